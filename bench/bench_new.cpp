@@ -0,0 +1,70 @@
+/*
+ * Time new/delete pairs through the global operators. Built twice: against
+ * the operators of ft_malloc_cxx, and against the default ones of the C++
+ * runtime, which only see malloc and free.
+ */
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+
+#define BENCH_BATCH         64
+#define BENCH_ITERATIONS    20000
+
+namespace {
+
+struct bench_case_s {
+    const char      *name;
+    std::size_t     size;
+    std::size_t     alignment;  // 0 for the default alignment
+};
+
+const bench_case_s bench_cases_g[] = {
+    {"tiny", 32, 0},
+    {"tiny_mixed", 8, 0},
+    {"small", 1024, 0},
+    {"medium", 16 * 1024, 0},
+    {"aligned_64", 48, 64},
+    {"aligned_4096", 1024, 4096},
+};
+
+/**
+ * @brief Allocate and free batches of \a size bytes, the sizes of
+ * tiny_mixed grow with their position in the batch
+ * @return The mean time of a new/delete pair, in nanoseconds
+ */
+double bench_run(const bench_case_s &bench) {
+    void *ptrs[BENCH_BATCH];
+    std::size_t sizes[BENCH_BATCH];
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < BENCH_BATCH; i++) {
+        sizes[i] = bench.size * (bench.size < 16 ? i % 16 + 1 : 1);
+    }
+    for (std::size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        for (std::size_t j = 0; j < BENCH_BATCH; j++) {
+            ptrs[j] = bench.alignment
+                ? ::operator new(sizes[j], std::align_val_t(bench.alignment))
+                : ::operator new(sizes[j]);
+        }
+        for (std::size_t j = BENCH_BATCH; j-- > 0;) {
+            if (bench.alignment) {
+                ::operator delete(ptrs[j], sizes[j], std::align_val_t(bench.alignment));
+            } else {
+                ::operator delete(ptrs[j], sizes[j]);
+            }
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (BENCH_ITERATIONS * BENCH_BATCH);
+}
+
+}
+
+int main() {
+    std::printf("%-16s %12s\n", "case", "ns/pair");
+    for (const bench_case_s &bench : bench_cases_g) {
+        std::printf("%-16s %12.1f\n", bench.name, bench_run(bench));
+    }
+    return 0;
+}
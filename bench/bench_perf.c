@@ -0,0 +1,300 @@
+/*
+ * Hardware counters of the malloc and free hot paths, per operation, checked
+ * against a baseline. Counters the kernel or the machine doesn't provide are
+ * reported as such and left out of the check.
+ *
+ * usage: bench_perf [--record] [--threshold percent] baseline
+ *   --record       Write the measures to baseline instead of checking them
+ *   --threshold    Regression allowed before the run fails, 10% by default
+ *
+ * Exits with 1 when a measure regressed, and with BENCH_PERF_SKIP when no
+ * counter could be opened, so that ctest reports the test as skipped.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#include "malloc.h"
+#include "free.h"
+#include "realloc.h"
+
+#define BENCH_PERF_SKIP         77
+#define BENCH_PERF_THRESHOLD    10.0
+#define BENCH_PERF_SLACK        0.01    // Per operation, so that near zero measures don't flap
+#define BENCH_PERF_BATCH        256
+#define BENCH_PERF_ROUNDS       2000
+#define BENCH_PERF_WARMUP       50
+#define BENCH_PERF_LINE_SIZE    256
+
+#define BENCH_PERF_CACHE(cache, op, result) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_##op << 8) | (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+typedef struct {
+    const char  *name;
+    uint32_t    type;
+    uint64_t    config;
+} bench_metric_t;
+
+typedef struct {
+    const char  *name;
+    size_t      (*routine)(void **ptrs, uint64_t *random);    // Returns its operation count
+} bench_case_t;
+
+static size_t   bench_tiny(void **ptrs, uint64_t *random);
+static size_t   bench_small(void **ptrs, uint64_t *random);
+static size_t   bench_medium(void **ptrs, uint64_t *random);
+static size_t   bench_mixed(void **ptrs, uint64_t *random);
+static size_t   bench_realloc(void **ptrs, uint64_t *random);
+static size_t   bench_pairs(void **ptrs, size_t size);
+static bool     bench_measure(const bench_case_t *bench, double *measures, bool *supported);
+static int      bench_open(const bench_metric_t *metric);
+static bool     bench_baseline(const char *path, const char *name, const char *metric, double *value);
+static uint64_t bench_random(uint64_t *state);
+
+static const bench_metric_t bench_metrics_g[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"l1d_misses", PERF_TYPE_HW_CACHE, BENCH_PERF_CACHE(PERF_COUNT_HW_CACHE_L1D, READ, MISS)},
+    {"llc_misses", PERF_TYPE_HW_CACHE, BENCH_PERF_CACHE(PERF_COUNT_HW_CACHE_LL, READ, MISS)},
+    {"dtlb_misses", PERF_TYPE_HW_CACHE, BENCH_PERF_CACHE(PERF_COUNT_HW_CACHE_DTLB, READ, MISS)},
+    {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+#define BENCH_METRIC_COUNT (sizeof(bench_metrics_g) / sizeof(*bench_metrics_g))
+
+static const bench_case_t bench_cases_g[] = {
+    {"tiny", bench_tiny},
+    {"small", bench_small},
+    {"medium", bench_medium},
+    {"mixed", bench_mixed},
+    {"realloc", bench_realloc},
+};
+
+int main(int argc, char **argv) {
+    double threshold = BENCH_PERF_THRESHOLD;
+    const char *path = NULL;
+    bool record = false;
+    bool supported[BENCH_METRIC_COUNT];
+    double measures[BENCH_METRIC_COUNT];
+    double baseline;
+    size_t regressions = 0;
+    FILE *output = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = strtod(argv[++i], NULL);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == NULL) {
+        fprintf(stderr, "usage: %s [--record] [--threshold percent] baseline\n", argv[0]);
+        return 1;
+    }
+    if (record && (output = fopen(path, "w")) == NULL) {
+        perror(path);
+        return 1;
+    }
+    if (output != NULL) {
+        fprintf(output, "# case metric per_operation, written by bench_perf --record\n");
+    }
+    printf("%-8s %-13s %12s %12s\n", "case", "metric", "per op", "baseline");
+    for (size_t i = 0; i < sizeof(bench_cases_g) / sizeof(*bench_cases_g); i++) {
+        if (!bench_measure(&bench_cases_g[i], measures, supported)) {
+            printf("no counter available\n");
+            return BENCH_PERF_SKIP;
+        }
+        for (size_t j = 0; j < BENCH_METRIC_COUNT; j++) {
+            if (!supported[j]) {
+                printf("%-8s %-13s %12s\n", bench_cases_g[i].name, bench_metrics_g[j].name, "unsupported");
+                continue;
+            }
+            if (output != NULL) {
+                fprintf(output, "%s %s %.4f\n", bench_cases_g[i].name, bench_metrics_g[j].name, measures[j]);
+            }
+            if (record || !bench_baseline(path, bench_cases_g[i].name, bench_metrics_g[j].name, &baseline)) {
+                printf("%-8s %-13s %12.4f\n", bench_cases_g[i].name, bench_metrics_g[j].name, measures[j]);
+                continue;
+            }
+            if (measures[j] > baseline * (1 + threshold / 100) + BENCH_PERF_SLACK) {
+                regressions++;
+                printf("%-8s %-13s %12.4f %12.4f REGRESSION\n", bench_cases_g[i].name, bench_metrics_g[j].name, measures[j], baseline);
+            } else {
+                printf("%-8s %-13s %12.4f %12.4f\n", bench_cases_g[i].name, bench_metrics_g[j].name, measures[j], baseline);
+            }
+        }
+    }
+    if (output != NULL) {
+        fclose(output);
+    }
+    printf("%zu regressions above %.1f%%\n", regressions, threshold);
+    return regressions != 0;
+}
+
+/**
+ * @brief Run \a bench BENCH_PERF_WARMUP times to warm the allocator up, then
+ * again with every counter enabled
+ * @param measures Set to the counts per operation
+ * @param supported Set to whether each counter could be opened
+ * @return false if no counter could be opened
+ */
+static bool bench_measure(const bench_case_t *bench, double *measures, bool *supported) {
+    void *ptrs[BENCH_PERF_BATCH];
+    uint64_t random = 0x9E3779B97F4A7C15;
+    int fds[BENCH_METRIC_COUNT];
+    bool any = false;
+    size_t ops = 0;
+    uint64_t count;
+
+    for (size_t i = 0; i < BENCH_PERF_WARMUP; i++) {
+        bench->routine(ptrs, &random);
+    }
+    for (size_t i = 0; i < BENCH_METRIC_COUNT; i++) {
+        fds[i] = bench_open(&bench_metrics_g[i]);
+        supported[i] = fds[i] >= 0;
+        any |= supported[i];
+    }
+    for (size_t i = 0; i < BENCH_METRIC_COUNT; i++) {
+        if (fds[i] >= 0) {
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    for (size_t i = 0; i < BENCH_PERF_ROUNDS; i++) {
+        ops += bench->routine(ptrs, &random);
+    }
+    for (size_t i = 0; i < BENCH_METRIC_COUNT; i++) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        supported[i] = read(fds[i], &count, sizeof(count)) == sizeof(count);
+        if (supported[i]) {
+            measures[i] = (double)count / ops;
+        }
+        close(fds[i]);
+    }
+    return any;
+}
+
+/**
+ * @brief Open a counter of the calling thread, user space only
+ * @return The file descriptor of the counter, -1 if it isn't available
+ */
+static int bench_open(const bench_metric_t *metric) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = metric->type;
+    attr.config = metric->config;
+    attr.disabled = 1;
+    //Page faults are taken in the kernel, the other events only matter in the allocator
+    attr.exclude_kernel = metric->type != PERF_TYPE_SOFTWARE;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Look the value of \a metric for \a name up in the baseline file
+ * @return false if the baseline has no such value
+ */
+static bool bench_baseline(const char *path, const char *name, const char *metric, double *value) {
+    char line[BENCH_PERF_LINE_SIZE];
+    char line_name[BENCH_PERF_LINE_SIZE];
+    char line_metric[BENCH_PERF_LINE_SIZE];
+    FILE *file = fopen(path, "r");
+    bool found = false;
+
+    if (file == NULL) {
+        return false;
+    }
+    while (!found && fgets(line, sizeof(line), file) != NULL) {
+        found = line[0] != '#'
+            && sscanf(line, "%255s %255s %lf", line_name, line_metric, value) == 3
+            && strcmp(line_name, name) == 0 && strcmp(line_metric, metric) == 0;
+    }
+    fclose(file);
+    return found;
+}
+
+static size_t bench_tiny(void **ptrs, uint64_t *random) {
+    (void)random;
+    return bench_pairs(ptrs, 32);
+}
+
+static size_t bench_small(void **ptrs, uint64_t *random) {
+    (void)random;
+    return bench_pairs(ptrs, 1024);
+}
+
+static size_t bench_medium(void **ptrs, uint64_t *random) {
+    (void)random;
+    return bench_pairs(ptrs, 16 * 1024);
+}
+
+/**
+ * @brief Allocate a batch of \a size bytes chunks, then free it in reverse
+ * @return The number of malloc and free calls
+ */
+static size_t bench_pairs(void **ptrs, size_t size) {
+    for (size_t i = 0; i < BENCH_PERF_BATCH; i++) {
+        ptrs[i] = malloc(size);
+    }
+    for (size_t i = BENCH_PERF_BATCH; i-- > 0;) {
+        free(ptrs[i]);
+    }
+    return BENCH_PERF_BATCH * 2;
+}
+
+/**
+ * @brief Allocate a batch of random tiny and small sizes, then free every
+ * other chunk before the rest, to leave holes for the next round
+ */
+static size_t bench_mixed(void **ptrs, uint64_t *random) {
+    for (size_t i = 0; i < BENCH_PERF_BATCH; i++) {
+        ptrs[i] = malloc(bench_random(random) % 2048 + 1);
+    }
+    for (size_t i = 0; i < BENCH_PERF_BATCH; i += 2) {
+        free(ptrs[i]);
+    }
+    for (size_t i = 1; i < BENCH_PERF_BATCH; i += 2) {
+        free(ptrs[i]);
+    }
+    return BENCH_PERF_BATCH * 2;
+}
+
+/**
+ * @brief Grow a batch of chunks from tiny to small by steps
+ */
+static size_t bench_realloc(void **ptrs, uint64_t *random) {
+    (void)random;
+    for (size_t i = 0; i < BENCH_PERF_BATCH; i++) {
+        ptrs[i] = malloc(16);
+    }
+    for (size_t size = 64; size <= 2048; size *= 2) {
+        for (size_t i = 0; i < BENCH_PERF_BATCH; i++) {
+            ptrs[i] = realloc(ptrs[i], size);
+        }
+    }
+    for (size_t i = 0; i < BENCH_PERF_BATCH; i++) {
+        free(ptrs[i]);
+    }
+    return BENCH_PERF_BATCH * 8;
+}
+
+// xorshift64
+static uint64_t bench_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
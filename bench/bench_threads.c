@@ -0,0 +1,315 @@
+/*
+ * Multithreaded scalability of malloc and free. The program only calls the
+ * malloc of the process, so that it measures glibc when run as is and
+ * ft_malloc when run with LD_PRELOAD=libft_malloc.so.
+ *
+ * usage: bench_threads [max_threads] [duration_ms]
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_DURATION_MS       500
+#define BENCH_LARSON_SLOTS      1000
+#define BENCH_LARSON_ROUND      10000   // Operations before a thread hands its slots over
+#define BENCH_LARSON_MIN        8
+#define BENCH_LARSON_MAX        1024
+#define BENCH_RING_SIZE         1024    // Must be a power of two
+#define BENCH_CHURN_BATCH       100
+#define BENCH_CHURN_SIZE        64
+#define BENCH_SHARING_SIZE      8
+#define BENCH_SHARING_WRITES    1000
+
+/**
+ * Single producer, single consumer queue of the chunks a producer hands over
+ * to its consumer. Each index lives on its own cache line.
+ */
+typedef struct {
+    _Alignas(64) _Atomic size_t head;
+    _Alignas(64) _Atomic size_t tail;
+    _Alignas(64) _Atomic bool   done;
+    void                        *slots[BENCH_RING_SIZE];
+} bench_ring_t;
+
+typedef struct {
+    size_t      index;
+    uint64_t    ops;
+    uint64_t    random;
+} bench_worker_t;
+
+typedef struct {
+    const char  *name;
+    const char  *description;
+    void        *(*routine)(void *arg);
+    size_t      thread_step;        // The thread count must be a multiple of it
+} bench_case_t;
+
+typedef struct {
+    _Atomic bool        stop;
+    size_t              thread_count;
+    pthread_barrier_t   barrier;
+    void                **_Atomic *larson_pool;
+    bench_ring_t        *rings;
+} bench_t;
+
+static void     *bench_larson(void *arg);
+static void     *bench_producer_consumer(void *arg);
+static void     *bench_churn(void *arg);
+static void     *bench_false_sharing(void *arg);
+static uint64_t bench_run(const bench_case_t *bench, size_t thread_count, size_t duration_ms);
+static void     **bench_larson_block(uint64_t *random);
+static void     bench_larson_release(void **block);
+static uint64_t bench_random(uint64_t *state);
+static void     bench_sleep(size_t ms);
+
+static const bench_case_t bench_cases_g[] = {
+    {"larson", "server simulation, slots handed over between threads", bench_larson, 1},
+    {"prod_cons", "chunks freed by another thread than their allocator", bench_producer_consumer, 2},
+    {"churn", "batches allocated then freed by each thread", bench_churn, 1},
+    {"false_share", "chunks written to by their thread only", bench_false_sharing, 1},
+};
+
+static bench_t bench_g;
+
+int main(int argc, char **argv) {
+    const long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cpu_count > 0 ? cpu_count : 1;
+    size_t duration_ms = BENCH_DURATION_MS;
+    uint64_t base_ops;
+    size_t base_threads;
+    uint64_t ops;
+
+    if (argc > 1) {
+        max_threads = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        duration_ms = strtoul(argv[2], NULL, 10);
+    }
+    if (max_threads == 0 || duration_ms == 0) {
+        fprintf(stderr, "usage: %s [max_threads] [duration_ms]\n", argv[0]);
+        return 1;
+    }
+    printf("%-12s %8s %14s %11s\n", "case", "threads", "ops/s", "efficiency");
+    for (size_t i = 0; i < sizeof(bench_cases_g) / sizeof(*bench_cases_g); i++) {
+        const bench_case_t *bench = &bench_cases_g[i];
+
+        base_ops = 0;
+        base_threads = 0;
+        //Powers of two, then max_threads
+        for (size_t threads = 1;; threads = threads * 2 > max_threads ? max_threads : threads * 2) {
+            if (threads % bench->thread_step == 0) {
+                ops = bench_run(bench, threads, duration_ms) * 1000 / duration_ms;
+                if (base_threads == 0) {
+                    base_ops = ops;
+                    base_threads = threads;
+                }
+                //The rate per thread, relative to the one of the smallest run
+                printf("%-12s %8zu %14lu %10.1f%%\n", bench->name, threads, ops,
+                       base_ops ? 100.0 * ops * base_threads / threads / base_ops : 0);
+            }
+            if (threads == max_threads) {
+                break;
+            }
+        }
+        printf("%-12s %s\n\n", "", bench->description);
+    }
+    return 0;
+}
+
+/**
+ * @brief Run \a thread_count workers of \a bench for \a duration_ms
+ * @return The number of operations made by all the workers
+ */
+static uint64_t bench_run(const bench_case_t *bench, size_t thread_count, size_t duration_ms) {
+    pthread_t threads[thread_count];
+    bench_worker_t workers[thread_count];
+    bench_ring_t rings[thread_count / 2 + 1];
+    void **_Atomic pool[thread_count];
+    uint64_t ops = 0;
+
+    atomic_store(&bench_g.stop, false);
+    bench_g.thread_count = thread_count;
+    bench_g.larson_pool = pool;
+    bench_g.rings = rings;
+    pthread_barrier_init(&bench_g.barrier, NULL, thread_count + 1);
+    for (size_t i = 0; i < thread_count; i++) {
+        workers[i] = (bench_worker_t){.index = i, .ops = 0, .random = i * 0x9E3779B97F4A7C15 + 1};
+        atomic_init(&pool[i], bench->routine == bench_larson ? bench_larson_block(&workers[i].random) : NULL);
+    }
+    for (size_t i = 0; i < thread_count / 2 + 1; i++) {
+        atomic_init(&rings[i].head, 0);
+        atomic_init(&rings[i].tail, 0);
+        atomic_init(&rings[i].done, false);
+    }
+    for (size_t i = 0; i < thread_count; i++) {
+        if (pthread_create(&threads[i], NULL, bench->routine, &workers[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    //Workers are all created before the clock starts
+    pthread_barrier_wait(&bench_g.barrier);
+    bench_sleep(duration_ms);
+    atomic_store(&bench_g.stop, true);
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+        ops += workers[i].ops;
+    }
+    for (size_t i = 0; i < thread_count; i++) {
+        bench_larson_release(atomic_load(&pool[i]));
+    }
+    pthread_barrier_destroy(&bench_g.barrier);
+    return ops;
+}
+
+/**
+ * @brief Larson: replace random slots of a block with chunks of random sizes.
+ * Every BENCH_LARSON_ROUND operations, the block is swapped with the one left
+ * in the pool by a neighbour, whose chunks are then freed by this thread.
+ */
+static void *bench_larson(void *arg) {
+    bench_worker_t *worker = arg;
+    void **block = bench_larson_block(&worker->random);
+    const size_t next = (worker->index + 1) % bench_g.thread_count;
+    size_t slot;
+
+    pthread_barrier_wait(&bench_g.barrier);
+    while (!atomic_load_explicit(&bench_g.stop, memory_order_relaxed)) {
+        for (size_t i = 0; i < BENCH_LARSON_ROUND; i++) {
+            slot = bench_random(&worker->random) % BENCH_LARSON_SLOTS;
+            free(block[slot]);
+            block[slot] = malloc(BENCH_LARSON_MIN + bench_random(&worker->random) % (BENCH_LARSON_MAX - BENCH_LARSON_MIN));
+        }
+        worker->ops += BENCH_LARSON_ROUND;
+        block = atomic_exchange(&bench_g.larson_pool[next], block);
+    }
+    bench_larson_release(block);
+    return NULL;
+}
+
+/**
+ * @brief Even workers allocate and hand the chunks to the next odd worker,
+ * which frees them. Only the frees are counted.
+ */
+static void *bench_producer_consumer(void *arg) {
+    bench_worker_t *worker = arg;
+    bench_ring_t *ring = &bench_g.rings[worker->index / 2];
+    size_t head;
+    size_t tail;
+
+    pthread_barrier_wait(&bench_g.barrier);
+    if (worker->index % 2 == 0) {
+        while (!atomic_load_explicit(&bench_g.stop, memory_order_relaxed)) {
+            tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            if (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == BENCH_RING_SIZE) {
+                sched_yield();
+                continue;
+            }
+            ring->slots[tail % BENCH_RING_SIZE] = malloc(BENCH_CHURN_SIZE);
+            atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+        }
+        atomic_store_explicit(&ring->done, true, memory_order_release);
+        return NULL;
+    }
+    while (true) {
+        head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        if (head == atomic_load_explicit(&ring->tail, memory_order_acquire)) {
+            //The producer may have pushed its last chunks before it set done
+            if (atomic_load_explicit(&ring->done, memory_order_acquire)
+                && head == atomic_load_explicit(&ring->tail, memory_order_acquire)) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        free(ring->slots[head % BENCH_RING_SIZE]);
+        atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+        worker->ops++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Threadtest: allocate a batch of chunks then free them, in each
+ * thread independently
+ */
+static void *bench_churn(void *arg) {
+    bench_worker_t *worker = arg;
+    void *batch[BENCH_CHURN_BATCH];
+
+    pthread_barrier_wait(&bench_g.barrier);
+    while (!atomic_load_explicit(&bench_g.stop, memory_order_relaxed)) {
+        for (size_t i = 0; i < BENCH_CHURN_BATCH; i++) {
+            batch[i] = malloc(BENCH_CHURN_SIZE);
+        }
+        for (size_t i = 0; i < BENCH_CHURN_BATCH; i++) {
+            free(batch[i]);
+        }
+        worker->ops += BENCH_CHURN_BATCH;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cache-thrash: each thread writes to small chunks of its own. An
+ * allocator placing chunks of different threads on the same cache line makes
+ * the writes contend although nothing is shared.
+ */
+static void *bench_false_sharing(void *arg) {
+    bench_worker_t *worker = arg;
+    volatile char *chunk;
+
+    pthread_barrier_wait(&bench_g.barrier);
+    while (!atomic_load_explicit(&bench_g.stop, memory_order_relaxed)) {
+        chunk = malloc(BENCH_SHARING_SIZE);
+        for (size_t i = 0; i < BENCH_SHARING_WRITES; i++) {
+            chunk[i % BENCH_SHARING_SIZE]++;
+        }
+        free((void*)chunk);
+        worker->ops++;
+    }
+    return NULL;
+}
+
+static void **bench_larson_block(uint64_t *random) {
+    void **block = malloc(BENCH_LARSON_SLOTS * sizeof(*block));
+
+    if (block == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+    for (size_t i = 0; i < BENCH_LARSON_SLOTS; i++) {
+        block[i] = malloc(BENCH_LARSON_MIN + bench_random(random) % (BENCH_LARSON_MAX - BENCH_LARSON_MIN));
+    }
+    return block;
+}
+
+static void bench_larson_release(void **block) {
+    if (block == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < BENCH_LARSON_SLOTS; i++) {
+        free(block[i]);
+    }
+    free(block);
+}
+
+// xorshift64
+static uint64_t bench_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void bench_sleep(size_t ms) {
+    const struct timespec duration = {.tv_sec = ms / 1000, .tv_nsec = ms % 1000 * 1000000};
+
+    nanosleep(&duration, NULL);
+}
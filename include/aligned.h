@@ -0,0 +1,10 @@
+#ifndef ALIGNED_H
+#define ALIGNED_H
+
+#include <stddef.h>
+
+void    *aligned_alloc(size_t alignment, size_t size);
+int     posix_memalign(void **memptr, size_t alignment, size_t size);
+void    *memalign(size_t alignment, size_t size);
+
+#endif //ALIGNED_H
@@ -0,0 +1,40 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chunk.h"
+#include "def.h"
+
+#define CACHE_BIN_COUNT     (TINY_CHUNK_SIZE / ALIGN_SIZE)
+#define CACHE_BIN_CAPACITY  15
+
+typedef enum {
+    CACHE_MODE_NONE,        // Not initialized yet
+    CACHE_MODE_DISABLED,
+    CACHE_MODE_THREAD,
+    CACHE_MODE_CPU,
+} cache_mode_t;
+
+/**
+ * A bin holds up to CACHE_BIN_CAPACITY chunks of a single tiny size.
+ * The layout is relied upon by the rseq critical sections: count must be the
+ * first field and slots must directly follow it.
+ */
+typedef struct {
+    size_t      count;
+    chunk_t     slots[CACHE_BIN_CAPACITY];
+} cache_bin_t;
+
+typedef struct {
+    cache_bin_t bins[CACHE_BIN_COUNT];
+} cache_t;
+
+cache_mode_t    cache_init(void);
+chunk_t         cache_pop(size_t size);
+bool            cache_push(chunk_t chunk);
+bool            cache_contains(chunk_t chunk);
+void            cache_flush(void);
+
+#endif //CACHE_H
@@ -2,11 +2,14 @@
 #define CHUNK_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 #define CHUNK_PER_ZONE      128
 #define TINY_CHUNK_SIZE     128
 #define SMALL_CHUNK_SIZE    4096
+#define MEDIUM_CHUNK_SIZE   (256 * 1024)
+#define MEDIUM_CHUNK_PER_ZONE 16
 #define CHUNK_METADATA_SIZE (sizeof(void*) * 3 + sizeof(size_t))
 
 typedef struct chunk_s *chunk_t;
@@ -24,15 +27,24 @@ struct chunk_s {
 };
 
 chunk_t     chunk_get(size_t size);
+chunk_t     chunk_get_aligned(size_t size, size_t alignment);
+chunk_t     chunk_get_zone(zone_t *zone_head, zone_t *zone_rover, size_t size);
+size_t      chunk_round_size(size_t size);
 void        chunk_init(chunk_t chunk, size_t size);
 chunk_t     chunk_new(size_t size);
-void        chunk_push_back(chunk_t *head, chunk_t chunk);
+bool        chunk_resize_large(chunk_t chunk, size_t size);
+void        chunk_large_threshold_update(chunk_t chunk, size_t birth);
 chunk_t     chunk_search(chunk_t c_head, size_t size);
 chunk_t     chunk_split(chunk_t chunk, size_t size);
+bool        chunk_fusable(chunk_t neighbour);
 void        chunk_fusion(chunk_t chunk);
 void        chunk_fusion_next(chunk_t chunk);
 void        chunk_fusion_prev(chunk_t chunk);
 void        chunk_copy(chunk_t src, chunk_t dst);
 chunk_t     chunk_validate(void *addr, zone_t *zone, zone_t **zone_head);
+bool        chunk_check(chunk_t chunk);
+void        chunk_seal(chunk_t chunk);
+void        chunk_tree_insert(zone_t *zone_head, zone_t zone, chunk_t chunk);
+void        chunk_tree_remove(zone_t *zone_head, chunk_t chunk);
 
 #endif //CHUNK_H
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef CLASS_H
+#define CLASS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "def.h"
+
+#define CLASS_SMALL_MIN     2048
+#define CLASS_SMALL_MAX     (4 * SMALL_CHUNK_SIZE)
+#define CLASS_SMALL_STEP    256     // Small boundaries are tried by this step
+#define CLASS_BUCKET_COUNT  (CLASS_SMALL_MAX / ALIGN_SIZE)
+#define CLASS_TUNE_PERIOD   (1 << 16)   // Requests between two tunings
+#define CLASS_TUNE_GAIN     8           // The boundaries move for a gain of at least 1/CLASS_TUNE_GAIN
+
+/**
+ * Sizes requested from a heap with adaptive classes, by aligned size up to
+ * CLASS_SMALL_MAX. Bigger requests are never moved by the boundaries.
+ */
+typedef struct {
+    uint32_t    counts[CLASS_BUCKET_COUNT]; // Halved at each tuning, so that old requests fade out
+    size_t      samples;                    // Requests since the last tuning
+    size_t      tunings;                    // Times the boundaries moved
+    size_t      saved;                      // Page rounding avoided by the last move, see class_info_t
+} class_t;
+
+typedef struct {
+    size_t  tiny_max;   // Biggest size served from the tiny zones
+    size_t  small_max;  // Biggest size served from the small zones
+    size_t  tunings;
+    size_t  saved;      // Bytes of page rounding the last move avoids every CLASS_TUNE_PERIOD requests, 0 if it grew it
+} class_info_t;
+
+void    class_record(size_t requested);
+void    class_tune(void);
+void    class_get(class_info_t *info);
+
+#endif //CLASS_H
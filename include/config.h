@@ -0,0 +1,47 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+
+#define CONFIG_LARGE_THRESHOLD_MIN      (256 * 1024)
+#define CONFIG_LARGE_THRESHOLD_MAX      (4 * 1024 * 1024)
+#define CONFIG_LARGE_THRESHOLD_WINDOW   1024
+#define CONFIG_DECAY_MS                 1000
+
+#define CONFIG_ENV_LARGE_THRESHOLD_MIN      "FT_MALLOC_LARGE_THRESHOLD_MIN"
+#define CONFIG_ENV_LARGE_THRESHOLD_MAX      "FT_MALLOC_LARGE_THRESHOLD_MAX"
+#define CONFIG_ENV_LARGE_THRESHOLD_WINDOW   "FT_MALLOC_LARGE_THRESHOLD_WINDOW"
+#define CONFIG_ENV_BACKGROUND               "FT_MALLOC_BACKGROUND"
+#define CONFIG_ENV_DECAY_MS                 "FT_MALLOC_DECAY_MS"
+#define CONFIG_ENV_LIMIT                    "FT_MALLOC_LIMIT"
+#define CONFIG_ENV_PREFAULT                 "FT_MALLOC_PREFAULT"
+#define CONFIG_ENV_PREFAULT_LARGE_MAX       "FT_MALLOC_PREFAULT_LARGE_MAX"
+#define CONFIG_ENV_PREGROW                  "FT_MALLOC_PREGROW"
+#define CONFIG_ENV_LATENCY                  "FT_MALLOC_LATENCY"
+#define CONFIG_ENV_ADAPTIVE_CLASSES         "FT_MALLOC_ADAPTIVE_CLASSES"
+#define CONFIG_ENV_PROFILE                  "FT_MALLOC_PROFILE"
+
+/**
+ * Runtime tunables, read once from the environment when the library is loaded.
+ */
+typedef struct {
+    size_t  large_threshold_min;    // Initial and lowest zone/mmap threshold
+    size_t  large_threshold_max;    // Highest zone/mmap threshold
+    size_t  large_threshold_window; // Allocations after which a free isn't "soon"
+    size_t  background;             // Start the maintenance thread when not 0
+    size_t  decay_ms;               // Time an empty zone or mapping is kept by the maintenance thread
+    size_t  limit;                  // Soft limit of the mapped bytes, 0 for none
+    size_t  prefault;               // Fault in the pages of new zones when not 0
+    size_t  prefault_large_max;     // Biggest large mapping faulted in, with prefault
+    size_t  pregrow;                // Map zones from the maintenance thread before they run out
+    size_t  latency;                // Record latency histograms, with MALLOC_LATENCY
+    size_t  adaptive_classes;       // Tune the small boundary to the sizes requested
+    const char *profile;            // Zone profile prewarmed from at startup and written at exit, NULL for none
+} config_t;
+
+extern config_t config_g;
+
+void    config_init(void);
+void    config_clamp(config_t *config);
+
+#endif //CONFIG_H
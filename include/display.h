@@ -3,5 +3,6 @@
 
 void display_memory(void);
 void display_memory_ex(void);
+void display_stats(void);
 
 #endif //DISPLAY_H
@@ -0,0 +1,11 @@
+#ifndef DUMP_H
+#define DUMP_H
+
+#define DUMP_BUFFER_SIZE    4096
+
+int dump_memory(int fd);
+int dump_signal(int signum, int fd);
+int dump_snapshot(int fd);
+int dump_snapshot_file(const char *path);
+
+#endif //DUMP_H
@@ -1,6 +1,14 @@
 #ifndef FREE_H
 #define FREE_H
 
+#include <stddef.h>
+
+#include "chunk.h"
+#include "zone.h"
+
 void free(void *ptr);
+void free_sized(void *ptr, size_t size);
+void free_ptr(void *ptr);
+void free_chunk(chunk_t chunk, zone_t zone, zone_t *zone_head);
 
-#endif //FREE_H
\ No newline at end of file
+#endif //FREE_H
@@ -0,0 +1,38 @@
+#ifndef HARDENING_H
+#define HARDENING_H
+
+#include <stdint.h>
+
+/**
+ * The hardening level is chosen when configuring the build:
+ * - MALLOC_HARDENING_FAST trusts the caller, free and realloc don't check the
+ *   magic, don't detect double frees and never write errors
+ * - the default level checks the magic and detects double frees
+ * - MALLOC_HARDENING_HARDENED also seals the chunk size and its next/prev
+ *   links in the magic, so an overflow rewriting a header is caught before
+ *   chunk_fusion follows its links, and encodes the pointers stored in free
+ *   chunks
+ */
+#ifdef MALLOC_HARDENING_FAST
+# define HARDENING_CHECK 0
+#else
+# define HARDENING_CHECK 1
+#endif
+
+#ifdef MALLOC_HARDENING_HARDENED
+/**
+ * Pointers stored in free memory are mixed with their own address and the
+ * process secret, so a use-after-free write can't forge a valid pointer.
+ * Encoding and decoding are the same operation.
+ */
+# define HARDENING_PROTECT(pos, ptr) \
+    ((__typeof__(ptr))(((uintptr_t)(pos) >> 12) ^ hardening_secret() ^ (uintptr_t)(ptr)))
+# define HARDENING_REVEAL(ptr) HARDENING_PROTECT(&(ptr), ptr)
+#else
+# define HARDENING_PROTECT(pos, ptr) (ptr)
+# define HARDENING_REVEAL(ptr) (ptr)
+#endif
+
+uintptr_t   hardening_secret(void);
+
+#endif //HARDENING_H
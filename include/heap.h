@@ -0,0 +1,26 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stddef.h>
+
+#include "config.h"
+#include "memory.h"
+
+typedef struct heap_s *heap_t;
+
+/**
+ * A private heap has its own zones, large mappings, stats, configuration
+ * and lock. Its chunks can only be freed or reallocated through it.
+ */
+struct heap_s {
+    memory_t    memory;
+    config_t    config;
+};
+
+heap_t  heap_create(const config_t *config);
+void    *heap_malloc(heap_t heap, size_t size);
+void    heap_free(heap_t heap, void *ptr);
+void    *heap_realloc(heap_t heap, void *ptr, size_t size);
+void    heap_destroy(heap_t heap);
+
+#endif //HEAP_H
@@ -0,0 +1,111 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+#endif
+
+// Log-linear buckets: each power of two is split in LATENCY_SUB_COUNT buckets
+#define LATENCY_SUB_BITS        3
+#define LATENCY_SUB_COUNT       (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKET_COUNT    ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef enum {
+    LATENCY_MALLOC,
+    LATENCY_FREE,
+    LATENCY_REALLOC,
+    LATENCY_OP_COUNT,
+} latency_op_t;
+
+/**
+ * The slowest thing a call did, a call is counted in a single path
+ */
+typedef enum {
+    LATENCY_PATH_FAST,      // Served from the cache or the existing zones
+    LATENCY_PATH_GROWTH,    // Mapped a new zone
+    LATENCY_PATH_SYSCALL,   // Mapped or unmapped a large chunk, or unmapped a zone
+    LATENCY_PATH_COUNT,
+} latency_path_t;
+
+/**
+ * Counts of the calls of each operation and path, written by their thread only
+ */
+typedef struct latency_block_s {
+    _Atomic uint64_t                buckets[LATENCY_OP_COUNT][LATENCY_PATH_COUNT][LATENCY_BUCKET_COUNT];
+    _Atomic bool                    used;       // Owned by a live thread
+    struct latency_block_s          *next;
+} latency_block_t;
+
+extern _Atomic bool latency_enabled_g;
+extern __thread latency_path_t latency_path_g __attribute__((tls_model("initial-exec")));
+
+void    latency_enable(bool enable);
+void    latency_record(latency_op_t op, uint64_t ticks);
+void    latency_collect(latency_op_t op, latency_path_t path, uint64_t *buckets);
+uint64_t latency_bucket_value(size_t bucket);
+
+/**
+ * @brief Read the cycle counter, or the monotonic clock in nanoseconds where
+ * there is none. This is the unit of every latency.
+ */
+static inline uint64_t latency_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Start timing an entry point. Without MALLOC_LATENCY, or while the
+ * histograms are disabled, it costs a single load.
+ * @return The start of the call, 0 if it isn't timed
+ */
+static inline uint64_t latency_start(void) {
+#ifdef MALLOC_LATENCY
+    if (atomic_load_explicit(&latency_enabled_g, memory_order_relaxed)) {
+        latency_path_g = LATENCY_PATH_FAST;
+        return latency_now();
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Record the call started at \a start in the histograms of the
+ * calling thread
+ */
+static inline void latency_end(latency_op_t op, uint64_t start) {
+#ifdef MALLOC_LATENCY
+    if (start != 0) {
+        latency_record(op, latency_now() - start);
+    }
+#else
+    (void)op;
+    (void)start;
+#endif
+}
+
+/**
+ * @brief Note that the current call took a slower \a path
+ */
+static inline void latency_mark(latency_path_t path) {
+#ifdef MALLOC_LATENCY
+    if (path > latency_path_g) {
+        latency_path_g = path;
+    }
+#else
+    (void)path;
+#endif
+}
+
+#endif //LATENCY_H
@@ -0,0 +1,22 @@
+#ifndef LIMIT_H
+#define LIMIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Above limit - limit / LIMIT_PRESSURE_RATIO, memory is given back eagerly
+#define LIMIT_PRESSURE_RATIO    8
+
+/**
+ * Called when an allocation of \a size bytes is about to fail, once the
+ * allocator released everything it could. No allocator lock is held, so the
+ * callback may free memory.
+ */
+typedef void (*limit_callback_t)(size_t size);
+
+void    limit_set_callback(limit_callback_t callback);
+bool    limit_check(size_t size);
+bool    limit_pressure(void);
+void    limit_reclaim(size_t size);
+
+#endif //LIMIT_H
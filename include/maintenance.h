@@ -0,0 +1,25 @@
+#ifndef MAINTENANCE_H
+#define MAINTENANCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "zone.h"
+
+#define MAINTENANCE_QUEUE_SIZE  64
+#define MAINTENANCE_PERIOD_MIN  10      // Milliseconds between two passes, at least
+#define MAINTENANCE_PREGROW_RATIO 4     // Pregrow a class once less than a zone / ratio is free
+#define MAINTENANCE_PURGE_PAGES 4       // Free pages a used zone must hold in a chunk to be queued
+
+bool    maintenance_start(void);
+void    maintenance_stop(void);
+void    maintenance_run(bool force);
+bool    maintenance_defer_zone(zone_t *zone_head, zone_t zone);
+bool    maintenance_defer_unmap(void *map, size_t size);
+void    *maintenance_reuse(size_t size);
+void    maintenance_notify(zone_t *zone_head);
+void    maintenance_fork_prepare(void);
+void    maintenance_fork_parent(void);
+void    maintenance_fork_child(void);
+
+#endif //MAINTENANCE_H
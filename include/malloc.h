@@ -4,5 +4,7 @@
 #include <stddef.h>
 
 void *malloc(size_t size);
+void *malloc_tiny(size_t size);
+void *malloc_small(size_t size);
 
 #endif //MALLOC_H
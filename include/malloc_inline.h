@@ -0,0 +1,34 @@
+#ifndef MALLOC_INLINE_H
+#define MALLOC_INLINE_H
+
+#include <stddef.h>
+
+#include "malloc.h"
+#include "chunk.h"
+#include "def.h"
+
+/**
+ * @brief Allocate \a size bytes. When \a size is a compile-time constant, as
+ * in malloc_inline(sizeof(struct foo)), the alignment and the class are
+ * resolved by the compiler and the class entry point is called directly. The
+ * entry point checks the runtime class boundaries and falls back to the
+ * generic path when class_tune moved them. Link with the static library to
+ * also skip the PLT.
+ * @param size The size to allocate
+ * @return The allocated memory, NULL on failure
+ */
+__attribute__((always_inline, malloc))
+static inline void *malloc_inline(size_t size) {
+    if (__builtin_constant_p(size)) {
+        if (ALIGN_MEM(size) <= TINY_CHUNK_SIZE) {
+            return malloc_tiny(size);
+        }
+        if (ALIGN_MEM(size) <= SMALL_CHUNK_SIZE) {
+            return malloc_small(size);
+        }
+    }
+    //Not a compile-time size, or above the largest small class
+    return malloc(size);
+}
+
+#endif //MALLOC_INLINE_H
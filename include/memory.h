@@ -1,14 +1,47 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+#include <pthread.h>
+
+#include "class.h"
+#include "config.h"
+#include "quick.h"
 #include "zone.h"
+#include "registry.h"
+#include "stats.h"
 
 typedef struct {
-    zone_t tiny_head;
-    zone_t small_head;
-    chunk_t large_head;
+    zone_t          tiny_head;
+    zone_t          small_head;
+    zone_t          medium_head;
+    zone_t          tiny_rover;     // Zone where the last search stopped
+    zone_t          small_rover;
+    zone_t          medium_rover;
+    registry_t      large;          // Large mappings, by address
+    chunk_t         small_tree;     // Free small chunks, used by MALLOC_BEST_FIT
+    quick_t         quick;          // Freed chunks not coalesced yet, used by MALLOC_QUICK_LIST
+    size_t          tiny_max;       // Biggest size served from the tiny zones
+    size_t          small_max;      // Biggest size served from the small zones
+    class_t         classes;        // Sizes requested, used with adaptive_classes
+    size_t          large_threshold;// Biggest size served from the medium zones
+    size_t          tick;           // Number of allocations, used as a clock
+    stats_t         stats[STATS_CLASS_COUNT];
+    size_t          reserved[STATS_CLASS_COUNT];    // Bytes of zones kept even when empty, see profile_prewarm
+    const config_t  *config;
+    pthread_mutex_t lock;
 } memory_t;
 
-extern memory_t memory_g;
+extern memory_t memory_main_g;
+extern __thread memory_t *memory_current_g __attribute__((tls_model("initial-exec")));
+
+/**
+ * The heap the calling thread works on: the main heap, or the private heap
+ * it holds the lock of (see heap.h)
+ */
+#define memory_g (*memory_current_g)
+
+void memory_lock(void);
+void memory_unlock(void);
+void memory_atfork(void);
 
-#endif //MEMORY_H
\ No newline at end of file
+#endif //MEMORY_H
@@ -0,0 +1,28 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "stats.h"
+
+#define PROFILE_BUFFER_SIZE     1024
+#define PROFILE_MAX_ZONES       4096    // Per class, a bigger count in the file is ignored
+
+/**
+ * Peak footprint of the zone classes of a previous run, in the file written
+ * by profile_save: a line "class zone_count mapped" per class, mapped being
+ * the bytes the class needed rather than the bytes it kept. The large
+ * class is left out, its mappings can't be made ahead of their chunks.
+ */
+typedef struct {
+    size_t  zone_count[STATS_CLASS_COUNT];
+    size_t  mapped[STATS_CLASS_COUNT];  // Metadata included
+} profile_t;
+
+void    profile_init(void);
+int     profile_save(const char *path);
+bool    profile_load(const char *path, profile_t *profile);
+size_t  profile_prewarm(const profile_t *profile);
+
+#endif //PROFILE_H
@@ -0,0 +1,47 @@
+#ifndef QUICK_H
+#define QUICK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chunk.h"
+#include "def.h"
+#include "hardening.h"
+#include "zone.h"
+
+#define QUICK_LIST_COUNT    (SMALL_CHUNK_SIZE / ALIGN_SIZE)
+#define QUICK_LIST_MAX      32      // A longer list is coalesced back into its zones
+#define QUICK_INDEX(size)   ((size) / ALIGN_SIZE - 1)
+
+/**
+ * Chunks in a quick list store their link in their data, so only chunks of
+ * at least QUICK_MIN_SIZE bytes are kept
+ */
+typedef struct quick_link_s {
+    chunk_t next;
+    zone_t  zone;
+} *quick_link_t;
+
+#define QUICK_LINK(chunk)           ((quick_link_t)(chunk)->data)
+#define QUICK_MIN_SIZE              sizeof(struct quick_link_s)
+// Links are encoded when built with MALLOC_HARDENING_HARDENED
+#define QUICK_NEXT(chunk)           HARDENING_REVEAL(QUICK_LINK(chunk)->next)
+#define QUICK_SET_NEXT(chunk, ptr)  (QUICK_LINK(chunk)->next = HARDENING_PROTECT(&QUICK_LINK(chunk)->next, ptr))
+#define QUICK_ZONE(chunk)           HARDENING_REVEAL(QUICK_LINK(chunk)->zone)
+#define QUICK_SET_ZONE(chunk, ptr)  (QUICK_LINK(chunk)->zone = HARDENING_PROTECT(&QUICK_LINK(chunk)->zone, ptr))
+
+/**
+ * Freed tiny and small chunks, by exact size, neither merged nor marked free.
+ * For the rest of the allocator, they are still used.
+ */
+typedef struct {
+    chunk_t heads[QUICK_LIST_COUNT];
+    size_t  counts[QUICK_LIST_COUNT];
+} quick_t;
+
+bool    quick_push(chunk_t chunk, zone_t zone, zone_t *zone_head);
+chunk_t quick_pop(size_t size);
+bool    quick_contains(chunk_t chunk);
+bool    quick_flush(zone_t *zone_head);
+
+#endif //QUICK_H
@@ -4,5 +4,6 @@
 #include <stddef.h>
 
 void *realloc(void *ptr, size_t size);
+void *realloc_chunk(void *ptr, size_t requested);
 
 #endif //REALLOC_H
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "zone.h"
+
+typedef struct region_s *region_t;
+
+/**
+ * A region hands out memory by bumping a pointer through its zones, and
+ * frees everything at once. It lives at the start of its first zone.
+ * A region is not thread safe, it's meant to be owned by a single request.
+ */
+struct region_s {
+    zone_t  head;       // First zone, holding the region itself
+    zone_t  current;    // Zone being bumped
+    uint8_t *top;       // First free byte of the current zone
+    uint8_t *end;       // End of the current zone
+};
+
+region_t    region_create(void);
+void        *region_alloc(region_t region, size_t size);
+void        region_reset(region_t region);
+void        region_destroy(region_t region);
+
+#endif //REGION_H
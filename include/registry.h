@@ -0,0 +1,35 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chunk.h"
+
+#define REGISTRY_MIN_CAPACITY   128
+
+/**
+ * Metadata of a large mapping, kept outside of the mapping itself.
+ * An entry whose chunk is NULL is empty.
+ */
+typedef struct {
+    chunk_t chunk;  // Used as the key, its mapping starts at the page containing it
+    size_t  size;   // Size of the mapping
+    size_t  birth;  // memory_g.tick when the chunk was mapped
+} registry_entry_t;
+
+/**
+ * Open addressing hash table of the large mappings, with linear probing
+ */
+typedef struct {
+    registry_entry_t    *entries;
+    size_t              capacity;   // Always a power of two
+    size_t              count;
+} registry_t;
+
+registry_entry_t    *registry_insert(registry_t *registry, chunk_t chunk);
+registry_entry_t    *registry_search(registry_t *registry, chunk_t chunk);
+void                registry_remove(registry_t *registry, registry_entry_t *entry);
+void                registry_clear(registry_t *registry);
+
+#endif //REGISTRY_H
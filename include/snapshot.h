@@ -0,0 +1,41 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+
+#define SNAPSHOT_MAGIC      0x50414e53  // "SNAP" in a little-endian file
+#define SNAPSHOT_VERSION    2
+
+/**
+ * A snapshot file is a snapshot_header_t followed by records, in the native
+ * byte order. Each zone record is followed by the records of its chunks, in
+ * address order. The last record is SNAPSHOT_END, a file without it was
+ * truncated.
+ */
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint64_t    tick;
+    uint64_t    large_threshold;
+    uint64_t    page_size;
+    uint64_t    tiny_max;       // Class boundaries when the snapshot was taken
+    uint64_t    small_max;
+} snapshot_header_t;
+
+typedef enum {
+    SNAPSHOT_ZONE,
+    SNAPSHOT_CHUNK,
+    SNAPSHOT_LARGE,
+    SNAPSHOT_END,
+} snapshot_type_t;
+
+typedef struct {
+    uint8_t     type;       // snapshot_type_t
+    uint8_t     class;      // stats_class_t of the zone or mapping
+    uint8_t     free;       // Chunks only
+    uint8_t     reserved[5];
+    uint64_t    address;    // Start of the zone, chunk header or mapping
+    uint64_t    size;       // Zone or chunk size without metadata, mapping size
+} snapshot_record_t;
+
+#endif //SNAPSHOT_H
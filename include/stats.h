@@ -0,0 +1,71 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "latency.h"
+#include "zone.h"
+
+// Free chunks are counted by the index of their highest bit
+#define STATS_BUCKET_COUNT  (sizeof(size_t) * 8)
+
+typedef enum {
+    STATS_TINY,
+    STATS_SMALL,
+    STATS_MEDIUM,
+    STATS_LARGE,
+    STATS_CLASS_COUNT,
+} stats_class_t;
+
+/**
+ * Counters of a size class, updated as chunks change state so that reading
+ * them never walks the chunks. Chunks held by the tiny cache count as used.
+ */
+typedef struct {
+    size_t  zone_count;     // Zones, or mappings for the large class
+    size_t  mapped;         // Bytes mapped, metadata included
+    size_t  peak_zone_count;
+    size_t  peak_mapped;    // Highest mapped since the start
+    size_t  used_count;
+    size_t  used_size;      // Bytes handed out, metadata excluded
+    size_t  peak_used;      // Highest used_size since the start, chunk metadata included, used by profile_save
+    size_t  free_count;
+    size_t  free_size;      // Metadata excluded
+    size_t  free_histogram[STATS_BUCKET_COUNT];
+    size_t  requested;      // Bytes asked by malloc and realloc since the start
+    size_t  granted;        // Bytes given for these requests, metadata included
+} stats_t;
+
+/**
+ * Latency percentiles of an entry point, in latency_now ticks: TSC cycles on
+ * x86, nanoseconds elsewhere. Values are the upper bound of their bucket.
+ */
+typedef struct {
+    uint64_t    count;
+    uint64_t    p50;
+    uint64_t    p99;
+    uint64_t    p999;
+    uint64_t    max;
+} stats_latency_t;
+
+stats_class_t   stats_class(size_t size);
+stats_t         *stats_of(zone_t *zone_head);
+void            stats_get(stats_class_t class, stats_t *stats);
+size_t          stats_mapped(void);
+size_t          stats_max_free(stats_class_t class);
+double          stats_external_fragmentation(stats_class_t class);
+double          stats_internal_fragmentation(stats_class_t class);
+bool            stats_latency(latency_op_t op, latency_path_t path, stats_latency_t *latency);
+
+void            stats_zone_add(zone_t *zone_head, size_t size);
+void            stats_zone_remove(zone_t *zone_head, size_t size);
+void            stats_used_add(zone_t *zone_head, size_t size);
+void            stats_used_remove(zone_t *zone_head, size_t size);
+void            stats_free_add(zone_t *zone_head, size_t size);
+void            stats_free_remove(zone_t *zone_head, size_t size);
+void            stats_request(size_t requested, chunk_t chunk);
+
+#endif //STATS_H
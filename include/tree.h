@@ -0,0 +1,36 @@
+#ifndef TREE_H
+#define TREE_H
+
+#include <stddef.h>
+
+#include "chunk.h"
+#include "hardening.h"
+
+/**
+ * Free chunks indexed by the best-fit tree store their node in their data, so
+ * only chunks of at least TREE_MIN_SIZE bytes can be indexed.
+ */
+typedef struct tree_node_s {
+    chunk_t left;
+    chunk_t right;
+    size_t  height;
+    zone_t  zone;   // Owning zone, set by chunk_tree_insert
+} *tree_node_t;
+
+#define TREE_NODE(chunk)    ((tree_node_t)(chunk)->data)
+#define TREE_MIN_SIZE       sizeof(struct tree_node_s)
+
+// Children are encoded when built with MALLOC_HARDENING_HARDENED
+#define TREE_LEFT(chunk)            HARDENING_REVEAL(TREE_NODE(chunk)->left)
+#define TREE_RIGHT(chunk)           HARDENING_REVEAL(TREE_NODE(chunk)->right)
+#define TREE_SET_LEFT(chunk, ptr)   (TREE_NODE(chunk)->left = HARDENING_PROTECT(&TREE_NODE(chunk)->left, ptr))
+#define TREE_SET_RIGHT(chunk, ptr)  (TREE_NODE(chunk)->right = HARDENING_PROTECT(&TREE_NODE(chunk)->right, ptr))
+#define TREE_ZONE(chunk)            HARDENING_REVEAL(TREE_NODE(chunk)->zone)
+#define TREE_SET_ZONE(chunk, ptr)   (TREE_NODE(chunk)->zone = HARDENING_PROTECT(&TREE_NODE(chunk)->zone, ptr))
+
+void    tree_insert(chunk_t *root, chunk_t chunk);
+void    tree_remove(chunk_t *root, chunk_t chunk);
+chunk_t tree_search(chunk_t root, size_t size);
+size_t  tree_height(chunk_t root);
+
+#endif //TREE_H
@@ -4,5 +4,6 @@
 #include <stddef.h>
 
 void *mmap_wrapper(size_t size);
+void mmap_prefault(void *addr, size_t size);
 
 #endif //UTILS_H
\ No newline at end of file
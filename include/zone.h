@@ -1,10 +1,13 @@
 #ifndef ZONE_H
 #define ZONE_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
-#define ZONE_METADATA_SIZE  (sizeof(void*) + sizeof(size_t))
+#define ZONE_METADATA_SIZE  (sizeof(void*) + sizeof(size_t) * 3)
+#define ZONE_GROWTH_RATIO   2       // A new zone is this fraction of what its class maps
+#define ZONE_GROWTH_MAX     (16 * 1024 * 1024)
 
 typedef struct chunk_s *chunk_t;
 typedef struct zone_s *zone_t;
@@ -12,12 +15,22 @@ typedef struct zone_s *zone_t;
 struct zone_s {
     size_t          size;
     struct zone_s   *next;
+    size_t          free_size;  // size minus the used chunks, metadata included
+    size_t          max_free;   // Upper bound of the biggest free chunk size
     uint8_t         data[1];
 };
 
 zone_t  zone_new(zone_t last, size_t chunk_size);
+zone_t  zone_grow(zone_t *zone_head, zone_t last, size_t chunk_size);
+size_t  zone_mapping_size(size_t chunk_size);
+size_t  zone_growth_size(zone_t *zone_head, size_t chunk_size);
+zone_t  zone_map(size_t zone_size);
 void    zone_unmap(zone_t* zone_head);
-chunk_t zone_search(zone_t z_head, zone_t *z_last, size_t size);
+void    zone_trim(zone_t *zone_head);
+bool    zone_remove(zone_t *zone_head, zone_t zone);
+bool    zone_empty(zone_t zone);
+bool    zone_reserved(zone_t *zone_head, zone_t zone);
+chunk_t zone_search(zone_t z_head, zone_t *z_rover, zone_t *z_last, size_t size);
 zone_t  zone_validate(uintptr_t addr, zone_t head);
 chunk_t zone_get_chunk(zone_t zone);
 
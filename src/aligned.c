@@ -0,0 +1,67 @@
+#include "aligned.h"
+
+#include <errno.h>
+#include <stdint.h>
+
+#include "chunk.h"
+#include "def.h"
+#include "memory.h"
+#include "stats.h"
+
+#define IS_POWER_OF_TWO(x) ((x) != 0 && ((x) & ((x) - 1)) == 0)
+
+static void *aligned_get(size_t alignment, size_t requested);
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    if (!IS_POWER_OF_TWO(alignment)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return aligned_get(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    void *ptr;
+
+    if (!IS_POWER_OF_TWO(alignment) || alignment % sizeof(void*) != 0) {
+        return EINVAL;
+    }
+    ptr = aligned_get(alignment, size);
+    if (ptr == NULL) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+void *memalign(size_t alignment, size_t size) {
+    return aligned_alloc(alignment, size);
+}
+
+/**
+ * @brief Allocate \a requested bytes aligned on \a alignment
+ * @param alignment A power of two
+ * @param requested The size asked by the caller, before alignment
+ * @return The allocated memory, NULL on failure
+ */
+static void *aligned_get(size_t alignment, size_t requested) {
+    chunk_t chunk;
+
+    //Keep room for the alignment padding without wrapping around
+    if (requested > SIZE_MAX / 2 || alignment > SIZE_MAX / 4) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memory_lock();
+    //May release the lock to reclaim memory, nothing is looked up before it
+    chunk = chunk_get_aligned(ALIGN_MEM(requested), alignment);
+    if (chunk != NULL) {
+        stats_request(requested, chunk);
+    }
+    memory_unlock();
+    if (chunk == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return chunk->data;
+}
@@ -0,0 +1,349 @@
+#include "cache.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/auxv.h>
+
+#if defined(__x86_64__) && __has_include(<sys/rseq.h>)
+# include <sys/rseq.h>
+# define CACHE_RSEQ
+#endif
+
+#include "free.h"
+#include "hardening.h"
+#include "memory.h"
+#include "utils.h"
+
+#define CACHE_BIN_INDEX(size) ((size) / ALIGN_SIZE - 1)
+// Written in the data of cached chunks, so that freeing one again is caught
+#define CACHE_MARK(chunk)      (((uintptr_t*)(chunk)->data)[0])
+
+#ifdef CACHE_RSEQ
+// Must match the signature glibc registered rseq with
+# define CACHE_RSEQ_SIG "0x53053053"
+
+/*
+ * Open a restartable sequence: the descriptor tells the kernel that if the
+ * thread is preempted or migrated between 1 and 2, it must resume at 4.
+ */
+# define CACHE_RSEQ_START                                   \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                    \
+    ".balign 32\n\t"                                        \
+    "3:\n\t"                                                \
+    ".long 0x0, 0x0\n\t"                                    \
+    ".quad 1f, (2f - 1f), 4f\n\t"                           \
+    ".popsection\n\t"                                       \
+    "leaq 3b(%%rip), %%rax\n\t"                             \
+    "movq %%rax, %[rseq_cs]\n\t"                            \
+    "1:\n\t"                                                \
+    "movl %[cpu_id], %%eax\n\t"                             \
+    "imulq %[stride], %%rax, %%rax\n\t"                     \
+    "addq %[base], %%rax\n\t"
+
+// The abort handler has to be preceded by the signature
+# define CACHE_RSEQ_END                                     \
+    "2:\n\t"                                                \
+    ".pushsection __rseq_failure, \"ax\"\n\t"               \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                            \
+    ".long " CACHE_RSEQ_SIG "\n\t"                          \
+    "4:\n\t"                                                \
+    "jmp %l[restart]\n\t"                                   \
+    ".popsection\n\t"
+
+static inline struct rseq *cache_rseq(void);
+static chunk_t  cache_cpu_pop(size_t index);
+static bool     cache_cpu_push(size_t index, chunk_t chunk);
+#endif
+
+static cache_t  *cache_thread_get(void);
+static void     cache_thread_destroy(void *arg);
+static void     cache_release(chunk_t chunk);
+
+static _Atomic cache_mode_t cache_mode_g = CACHE_MODE_NONE;
+static uintptr_t            cache_mark_g = 0;
+static cache_t              *cache_cpu_g = NULL;
+static pthread_key_t        cache_key_g;
+
+static __thread cache_t *cache_thread_g __attribute__((tls_model("initial-exec"))) = NULL;
+static __thread bool    cache_thread_busy_g __attribute__((tls_model("initial-exec"))) = false;
+
+/**
+ * @brief Select the cache mode: per-CPU bins when the thread is registered to
+ * rseq, per-thread bins otherwise
+ * @return The selected mode
+ */
+cache_mode_t cache_init(void) {
+    cache_mode_t mode;
+
+    memory_lock();
+    mode = atomic_load_explicit(&cache_mode_g, memory_order_relaxed);
+    if (mode != CACHE_MODE_NONE) {
+        memory_unlock();
+        return mode;
+    }
+    mode = CACHE_MODE_DISABLED;
+    //Not the hardening secret, which must never be written to user memory
+    cache_mark_g = (uintptr_t)&cache_mark_g;
+    if (getauxval(AT_RANDOM) != 0) {
+        memcpy(&cache_mark_g, (const uint8_t*)getauxval(AT_RANDOM) + sizeof(uintptr_t), sizeof(cache_mark_g));
+    }
+#ifdef CACHE_RSEQ
+    if (__rseq_size > 0 && (int32_t)cache_rseq()->cpu_id >= 0) {
+        const long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+
+        if (cpu_count > 0) {
+            //The mapping is zero filled so every bin starts empty
+            cache_cpu_g = mmap_wrapper(cpu_count * sizeof(cache_t));
+        }
+        if (cache_cpu_g != NULL) {
+            mode = CACHE_MODE_CPU;
+        }
+    }
+#endif
+    if (mode == CACHE_MODE_DISABLED && pthread_key_create(&cache_key_g, cache_thread_destroy) == 0) {
+        mode = CACHE_MODE_THREAD;
+    }
+    atomic_store_explicit(&cache_mode_g, mode, memory_order_release);
+    memory_unlock();
+    return mode;
+}
+
+/**
+ * @brief Take a chunk of exactly \a size bytes from the cache, without locking
+ * @param size The aligned size requested
+ * @return A chunk ready to be used, NULL if the cache can't serve \a size
+ */
+chunk_t cache_pop(size_t size) {
+    cache_mode_t mode;
+    cache_bin_t *bin;
+    cache_t *cache;
+    chunk_t chunk = NULL;
+
+    if (size == 0 || size > TINY_CHUNK_SIZE) {
+        return NULL;
+    }
+    mode = atomic_load_explicit(&cache_mode_g, memory_order_acquire);
+    if (mode == CACHE_MODE_NONE) {
+        mode = cache_init();
+    }
+#ifdef CACHE_RSEQ
+    if (mode == CACHE_MODE_CPU) {
+        chunk = cache_cpu_pop(CACHE_BIN_INDEX(size));
+    }
+#endif
+    if (mode == CACHE_MODE_THREAD && (cache = cache_thread_get()) != NULL) {
+        bin = &cache->bins[CACHE_BIN_INDEX(size)];
+        if (bin->count != 0) {
+            chunk = bin->slots[--bin->count];
+        }
+    }
+    if (HARDENING_CHECK && chunk != NULL) {
+        CACHE_MARK(chunk) = 0;
+    }
+    return chunk;
+}
+
+/**
+ * @brief Keep a chunk being freed in the cache instead of giving it back
+ * to its zone. The chunk stays marked as used for the rest of the allocator.
+ * Never allocates, so it can be called with the memory lock held: a thread
+ * gets its cache on its first cache_pop.
+ * @param chunk The chunk being freed, validated by the caller unless it's
+ * trusted (MALLOC_HARDENING_FAST)
+ * @return true if the chunk was cached, false if it must be freed normally
+ */
+bool cache_push(chunk_t chunk) {
+    cache_mode_t mode;
+    cache_bin_t *bin;
+    bool cached = false;
+
+    if (chunk->size == 0 || chunk->size > TINY_CHUNK_SIZE) {
+        return false;
+    }
+    mode = atomic_load_explicit(&cache_mode_g, memory_order_acquire);
+    //Marked before it's pushed, another thread may pop it right after
+    if (HARDENING_CHECK && mode != CACHE_MODE_NONE) {
+        CACHE_MARK(chunk) = cache_mark_g;
+    }
+#ifdef CACHE_RSEQ
+    if (mode == CACHE_MODE_CPU) {
+        cached = cache_cpu_push(CACHE_BIN_INDEX(chunk->size), chunk);
+    }
+#endif
+    if (mode == CACHE_MODE_THREAD && cache_thread_g != NULL) {
+        bin = &cache_thread_g->bins[CACHE_BIN_INDEX(chunk->size)];
+        if (bin->count != CACHE_BIN_CAPACITY) {
+            bin->slots[bin->count++] = chunk;
+            cached = true;
+        }
+    }
+    if (HARDENING_CHECK && !cached) {
+        CACHE_MARK(chunk) = 0;
+    }
+    return cached;
+}
+
+/**
+ * @brief Check whether a validated used chunk is held by a cache, to detect
+ * a double free. Only chunks pushed with HARDENING_CHECK are marked.
+ */
+bool cache_contains(chunk_t chunk) {
+    return HARDENING_CHECK && chunk->size != 0 && chunk->size <= TINY_CHUNK_SIZE
+        && atomic_load_explicit(&cache_mode_g, memory_order_acquire) != CACHE_MODE_NONE
+        && CACHE_MARK(chunk) == cache_mark_g;
+}
+
+/**
+ * @brief Give back every chunk held by the cache of the calling thread, or of
+ * the CPU it runs on, to its zone
+ */
+void cache_flush(void) {
+    const cache_mode_t mode = atomic_load_explicit(&cache_mode_g, memory_order_acquire);
+    cache_bin_t *bin;
+    chunk_t chunk;
+
+#ifdef CACHE_RSEQ
+    if (mode == CACHE_MODE_CPU) {
+        for (size_t i = 0; i < CACHE_BIN_COUNT; i++) {
+            while ((chunk = cache_cpu_pop(i)) != NULL) {
+                cache_release(chunk);
+            }
+        }
+        return;
+    }
+#endif
+    if (mode != CACHE_MODE_THREAD || cache_thread_g == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < CACHE_BIN_COUNT; i++) {
+        bin = &cache_thread_g->bins[i];
+        while (bin->count) {
+            cache_release(bin->slots[--bin->count]);
+        }
+    }
+}
+
+/**
+ * @brief Get the cache of the calling thread, allocating it on first use
+ * @return The thread cache, NULL if it couldn't be allocated
+ */
+static cache_t *cache_thread_get(void) {
+    chunk_t chunk;
+
+    if (cache_thread_g != NULL) {
+        return cache_thread_g;
+    }
+    //pthread_setspecific may allocate, in which case we must not recurse
+    if (cache_thread_busy_g) {
+        return NULL;
+    }
+    cache_thread_busy_g = true;
+    memory_lock();
+    //May release the lock to reclaim memory, nothing is looked up before it
+    chunk = chunk_get(sizeof(cache_t));
+    memory_unlock();
+    if (chunk != NULL) {
+        memset(chunk->data, 0, sizeof(cache_t));
+        if (pthread_setspecific(cache_key_g, chunk->data) == 0) {
+            cache_thread_g = (cache_t*)chunk->data;
+        } else {
+            cache_release(chunk);
+        }
+    }
+    cache_thread_busy_g = false;
+    return cache_thread_g;
+}
+
+/**
+ * @brief Thread exit destructor, release every cached chunk and the cache itself
+ * @param arg The cache of the exiting thread
+ */
+static void cache_thread_destroy(void *arg) {
+    cache_t *cache = arg;
+
+    cache_thread_g = cache;
+    cache_flush();
+    cache_thread_g = NULL;
+    cache_release((chunk_t)((void*)cache - CHUNK_METADATA_SIZE));
+}
+
+static void cache_release(chunk_t chunk) {
+    zone_t zone;
+    zone_t *zone_head;
+
+    if (HARDENING_CHECK) {
+        //The mark would outlive the chunk in the zone
+        CACHE_MARK(chunk) = 0;
+    }
+    memory_lock();
+    chunk_validate(chunk->data, &zone, &zone_head);
+    free_chunk(chunk, zone, zone_head);
+    memory_unlock();
+}
+
+#ifdef CACHE_RSEQ
+static inline struct rseq *cache_rseq(void) {
+    return (struct rseq*)((uintptr_t)__builtin_thread_pointer() + __rseq_offset);
+}
+
+/**
+ * @brief Pop a chunk from the bin \a index of the current CPU. The commit is
+ * the single store of the new count, so no atomic is needed.
+ */
+static chunk_t cache_cpu_pop(size_t index) {
+    struct rseq *rs = cache_rseq();
+    const uintptr_t base = (uintptr_t)&cache_cpu_g->bins[index];
+    chunk_t chunk = NULL;
+
+restart:
+    __asm__ goto (
+        CACHE_RSEQ_START
+        "movq (%%rax), %%rcx\n\t"
+        "testq %%rcx, %%rcx\n\t"
+        "jz %l[empty]\n\t"
+        "movq (%%rax, %%rcx, 8), %%rdx\n\t"
+        "movq %%rdx, (%[chunk])\n\t"
+        "decq %%rcx\n\t"
+        "movq %%rcx, (%%rax)\n\t"
+        CACHE_RSEQ_END
+        :
+        : [rseq_cs] "m" (rs->rseq_cs), [cpu_id] "m" (rs->cpu_id),
+          [stride] "i" (sizeof(cache_t)), [base] "r" (base), [chunk] "r" (&chunk)
+        : "memory", "cc", "rax", "rcx", "rdx"
+        : restart, empty);
+    return chunk;
+empty:
+    return NULL;
+}
+
+/**
+ * @brief Push \a chunk to the bin \a index of the current CPU. The slot is
+ * written first, then the new count is committed.
+ */
+static bool cache_cpu_push(size_t index, chunk_t chunk) {
+    struct rseq *rs = cache_rseq();
+    const uintptr_t base = (uintptr_t)&cache_cpu_g->bins[index];
+
+restart:
+    __asm__ goto (
+        CACHE_RSEQ_START
+        "movq (%%rax), %%rcx\n\t"
+        "cmpq %[capacity], %%rcx\n\t"
+        "jae %l[full]\n\t"
+        "movq %[chunk], 8(%%rax, %%rcx, 8)\n\t"
+        "incq %%rcx\n\t"
+        "movq %%rcx, (%%rax)\n\t"
+        CACHE_RSEQ_END
+        :
+        : [rseq_cs] "m" (rs->rseq_cs), [cpu_id] "m" (rs->cpu_id),
+          [stride] "i" (sizeof(cache_t)), [base] "r" (base),
+          [capacity] "i" (CACHE_BIN_CAPACITY), [chunk] "r" (chunk)
+        : "memory", "cc", "rax", "rcx"
+        : restart, full);
+    return true;
+full:
+    return false;
+}
+#endif
@@ -1,63 +1,355 @@
+#define _GNU_SOURCE
 #include "chunk.h"
 
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "free.h"
 #include "zone.h"
 #include "def.h"
 #include "utils.h"
 #include "memory.h"
+#include "tree.h"
+#include "hardening.h"
+#include "latency.h"
+#include "limit.h"
+#include "maintenance.h"
+#include "quick.h"
+#include "stats.h"
 
 #define MAGIC_SERIALIZE(x) (x << 8)
 #define MAGIC_DESERIALIZE(x) (x >> 8)
 
+static inline uintptr_t chunk_magic(chunk_t chunk);
+static chunk_t  chunk_get_large(size_t size, size_t alignment);
+static bool     chunk_reclaim(size_t size);
+static chunk_t  chunk_take_zone(zone_t *zone_head, zone_t *zone_rover, size_t size);
+static chunk_t  chunk_map_large(size_t size, size_t alignment);
+static chunk_t  chunk_cut(chunk_t chunk, size_t size, zone_t *zone_head);
 static void     chunk_copy8(chunk_t src, chunk_t dst);
 static void     chunk_copy16(chunk_t src, chunk_t dst);
 static void     chunk_copy32(chunk_t src, chunk_t dst);
 
+/**
+ * @brief Get a chunk of \a size bytes from the zones of its class, or from a
+ * new mapping above the zone/mmap threshold
+ * @param size The aligned size
+ * @return The chunk, NULL if memory couldn't be mapped
+ */
 chunk_t chunk_get(size_t size) {
+    if (size <= memory_g.tiny_max) {
+        return chunk_get_zone(&memory_g.tiny_head, &memory_g.tiny_rover, size);
+    }
+    if (size <= memory_g.small_max) {
+        return chunk_get_zone(&memory_g.small_head, &memory_g.small_rover, size);
+    }
+    if (size <= memory_g.large_threshold) {
+        return chunk_get_zone(&memory_g.medium_head, &memory_g.medium_rover, chunk_round_size(size));
+    }
+    return chunk_get_large(size, ALIGN_SIZE);
+}
+
+/**
+ * @brief Get a chunk of \a size bytes whose data is aligned on \a alignment.
+ * The chunk is cut out of a bigger one, the space before and after it is
+ * given back to its zone. Requests that would fall above the small class
+ * are mapped, since medium chunks must stay page-granular.
+ * @param size The aligned size
+ * @param alignment A power of two
+ * @return The chunk, NULL if memory couldn't be mapped
+ */
+chunk_t chunk_get_aligned(size_t size, size_t alignment) {
+    chunk_t chunk;
+    chunk_t aligned;
+    chunk_t remaining;
+    zone_t zone;
     zone_t *zone_head;
+    size_t lead;
+
+    if (alignment <= ALIGN_SIZE) {
+        return chunk_get(size);
+    }
+    //Room for the worst lead, and for the header of the aligned chunk
+    if (size + alignment + CHUNK_METADATA_SIZE + ALIGN_SIZE > memory_g.small_max) {
+        return chunk_get_large(size, alignment);
+    }
+    chunk = chunk_get(size + alignment + CHUNK_METADATA_SIZE + ALIGN_SIZE);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    //Looked up after chunk_get, which may have released the lock to reclaim
+    chunk_validate(chunk->data, &zone, &zone_head);
+    lead = (((uintptr_t)chunk->data + alignment - 1) & ~(alignment - 1)) - (uintptr_t)chunk->data;
+    if (lead != 0) {
+        //The chunk before the aligned one can't be empty
+        if (lead < CHUNK_METADATA_SIZE + ALIGN_SIZE) {
+            lead += alignment;
+        }
+        aligned = chunk_cut(chunk, lead - CHUNK_METADATA_SIZE, zone_head);
+        free_chunk(chunk, zone, zone_head);
+        chunk = aligned;
+    }
+    remaining = chunk_cut(chunk, size, zone_head);
+    if (remaining != NULL) {
+        free_chunk(remaining, zone, zone_head);
+    }
+    return chunk;
+}
+
+/**
+ * @brief Get a chunk from a given class, creating a zone if none has room.
+ * When no zone can be mapped, memory is reclaimed and the search is tried
+ * once more. Used directly by the per-class entry points, when the class is known at
+ * compile time.
+ * @param zone_head The head of the zone list of the class
+ * @param zone_rover The zone where the last search of the class stopped
+ * @param size The aligned size, page-granular for the medium class
+ * @return The chunk, NULL if a zone couldn't be mapped
+ */
+chunk_t chunk_get_zone(zone_t *zone_head, zone_t *zone_rover, size_t size) {
+    chunk_t chunk;
+
+#ifdef MALLOC_QUICK_LIST
+    chunk = quick_pop(size);
+    if (chunk != NULL) {
+        return chunk;
+    }
+#endif
+    chunk = chunk_take_zone(zone_head, zone_rover, size);
+    //The lock was released by the reclaim: the retry searches the zones again
+    if (chunk == NULL && chunk_reclaim(size)) {
+        chunk = chunk_take_zone(zone_head, zone_rover, size);
+    }
+    return chunk;
+}
+
+/**
+ * @brief Map a large chunk, see chunk_map_large. When it fails, memory is
+ * reclaimed and the mapping is tried once more.
+ */
+static chunk_t chunk_get_large(size_t size, size_t alignment) {
+    chunk_t chunk = chunk_map_large(size, alignment);
+
+    //Nothing found before the reclaim is kept, the retry maps from scratch
+    if (chunk == NULL && chunk_reclaim(size)) {
+        chunk = chunk_map_large(size, alignment);
+    }
+    return chunk;
+}
+
+/**
+ * @brief Release the memory the main heap holds without using it, before
+ * retrying an allocation that failed. The memory lock is released meanwhile,
+ * so the caller must not keep any zone or chunk it found before.
+ * @param size The size of the allocation that failed
+ * @return false if there is nothing to retry, for a private heap
+ */
+static bool chunk_reclaim(size_t size) {
+    if (&memory_g != &memory_main_g) {
+        return false;
+    }
+    memory_unlock();
+    limit_reclaim(size);
+    memory_lock();
+    return true;
+}
+
+/**
+ * @brief One attempt of chunk_get_zone, without reclaiming memory
+ */
+static chunk_t chunk_take_zone(zone_t *zone_head, zone_t *zone_rover, size_t size) {
     zone_t zone;
     zone_t last_zone;
     chunk_t chunk;
+    chunk_t remaining;
 
-    zone_head = NULL;
-    if (size <= TINY_CHUNK_SIZE) {
-        zone_head = &memory_g.tiny_head;
-    } else if (size <= SMALL_CHUNK_SIZE) {
-        zone_head = &memory_g.small_head;
-    }
-
-    if (zone_head != NULL) {
-        last_zone = NULL;
-        chunk = zone_search(*zone_head, &last_zone, size);
-        if (chunk == NULL) {
-            //If no chunk were found this mean we need to allocate more space
-            zone = zone_new(last_zone, size);
-            if (zone == NULL) {
-                return NULL;
-            }
-            if (*zone_head == NULL) {
-                *zone_head = zone;
-            }
-            chunk = zone_get_chunk(zone);
+    memory_g.tick++;
+    last_zone = NULL;
+#ifdef MALLOC_BEST_FIT
+    if (zone_head == &memory_g.small_head) {
+        chunk = tree_search(memory_g.small_tree, size);
+        if (chunk != NULL) {
+            tree_remove(&memory_g.small_tree, chunk);
+            zone = TREE_ZONE(chunk);
         }
-        chunk_split(chunk, size);
-        chunk->free = 0;
-    } else {
-        chunk = chunk_new(size);
-        if (chunk == NULL) {
+    } else
+#endif
+    {
+        chunk = zone_search(*zone_head, zone_rover, &last_zone, size);
+        zone = *zone_rover;
+    }
+    if (chunk == NULL) {
+#ifdef MALLOC_QUICK_LIST
+        //Coalescing the chunks kept aside may make room without a new zone
+        if (quick_flush(zone_head)) {
+            return chunk_take_zone(zone_head, zone_rover, size);
+        }
+#endif
+        //If no chunk were found this mean we need to allocate more space
+        zone = zone_grow(zone_head, last_zone, size);
+        if (zone == NULL) {
             return NULL;
         }
-        chunk_init(chunk, size);
-        chunk_push_back(&memory_g.large_head, chunk);
+        if (last_zone == NULL) {
+            //The zone list wasn't walked, so the new zone becomes the head
+            zone->next = *zone_head;
+            *zone_head = zone;
+        }
+        *zone_rover = zone;
+        chunk = zone_get_chunk(zone);
+        stats_zone_add(zone_head, zone->size + ZONE_METADATA_SIZE);
+        stats_free_add(zone_head, chunk->size);
+    }
+    stats_free_remove(zone_head, chunk->size);
+    remaining = chunk_split(chunk, size);
+    if (remaining != NULL) {
+        chunk_tree_insert(zone_head, zone, remaining);
+    }
+    chunk->free = 0;
+    zone->free_size -= chunk->size + CHUNK_METADATA_SIZE;
+    stats_used_add(zone_head, chunk->size);
+    maintenance_notify(zone_head);
+    return chunk;
+}
+
+/**
+ * @brief Map a large chunk whose data is aligned on \a alignment. The pages
+ * only used to reach the alignment are unmapped right away, so the mapping of
+ * the chunk starts at the page containing it.
+ * @param size The aligned size
+ * @param alignment A power of two, ALIGN_SIZE when no alignment is needed
+ * @return The chunk, NULL if memory couldn't be mapped
+ */
+static chunk_t chunk_map_large(size_t size, size_t alignment) {
+    const uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    const size_t slack = alignment > ALIGN_SIZE ? alignment : 0;
+    registry_entry_t *entry;
+    chunk_t chunk;
+    uintptr_t map;
+    uintptr_t start;
+    uintptr_t end;
+
+    memory_g.tick++;
+    //A mapping freed recently may still be held by the maintenance thread
+    map = alignment <= ALIGN_SIZE ? (uintptr_t)maintenance_reuse(size + CHUNK_METADATA_SIZE) : 0;
+    if (map == 0 && limit_check(size + slack + CHUNK_METADATA_SIZE)) {
+        latency_mark(LATENCY_PATH_SYSCALL);
+        map = (uintptr_t)chunk_new(size + slack);
+    }
+    if (map == 0) {
+        return NULL;
+    }
+    chunk = (chunk_t)(((map + CHUNK_METADATA_SIZE + alignment - 1) & ~(alignment - 1)) - CHUNK_METADATA_SIZE);
+    start = (uintptr_t)chunk & ~page_mask;
+    end = ((uintptr_t)chunk->data + size + page_mask) & ~page_mask;
+    if (start > map) {
+        munmap((void*)map, start - map);
+    }
+    if (map + size + slack + CHUNK_METADATA_SIZE > end) {
+        munmap((void*)end, map + size + slack + CHUNK_METADATA_SIZE - end);
+    }
+    if (memory_g.config->prefault && size <= memory_g.config->prefault_large_max) {
+        mmap_prefault((void*)start, end - start);
+    }
+    entry = registry_insert(&memory_g.large, chunk);
+    if (entry == NULL) {
+        munmap((void*)start, end - start);
+        return NULL;
     }
+    entry->size = (uintptr_t)chunk->data + size - start;
+    entry->birth = memory_g.tick;
+    chunk_init(chunk, size);
+    stats_zone_add(NULL, entry->size);
+    stats_used_add(NULL, size);
     return chunk;
 }
 
+/**
+ * @brief Resize a large chunk without moving it: the pages past its new end
+ * are unmapped, or the pages needed are mapped right after its mapping.
+ * The caller must hold the memory lock.
+ * @param chunk The large chunk
+ * @param size The new aligned size
+ * @return false if the chunk must be moved, because the pages after its
+ * mapping are taken or the limit would be exceeded
+ */
+bool chunk_resize_large(chunk_t chunk, size_t size) {
+    const uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    registry_entry_t *entry = registry_search(&memory_g.large, chunk);
+    const uintptr_t start = (uintptr_t)chunk & ~page_mask;
+    const uintptr_t end = (start + entry->size + page_mask) & ~page_mask;
+    const uintptr_t new_end = ((uintptr_t)chunk->data + size + page_mask) & ~page_mask;
+
+    if (new_end < end) {
+        latency_mark(LATENCY_PATH_SYSCALL);
+        if (munmap((void*)new_end, end - new_end) == -1) {
+            return false;
+        }
+    } else if (new_end > end) {
+        if (!limit_check(new_end - end)) {
+            return false;
+        }
+        latency_mark(LATENCY_PATH_SYSCALL);
+        //Without MREMAP_MAYMOVE, this fails if anything is mapped after the chunk
+        if (mremap((void*)start, end - start, new_end - start, 0) == MAP_FAILED) {
+            return false;
+        }
+    }
+    stats_zone_remove(NULL, entry->size);
+    stats_used_remove(NULL, chunk->size);
+    entry->size = (uintptr_t)chunk->data + size - start;
+    chunk->size = size;
+    chunk_seal(chunk);
+    stats_zone_add(NULL, entry->size);
+    stats_used_add(NULL, size);
+    return true;
+}
+
+/**
+ * @brief Split a used zone chunk in two used chunks, the first one keeping
+ * \a size bytes. The zone free size is unchanged.
+ * @param chunk The used chunk
+ * @param size The aligned size to keep in \a chunk
+ * @param zone_head The head of the zone list containing \a chunk
+ * @return The second chunk, NULL if there wasn't room for it
+ */
+static chunk_t chunk_cut(chunk_t chunk, size_t size, zone_t *zone_head) {
+    const size_t old_size = chunk->size;
+    chunk_t second;
+
+    second = chunk_split(chunk, size);
+    if (second == NULL) {
+        return NULL;
+    }
+    second->free = 0;
+    stats_used_remove(zone_head, old_size);
+    stats_used_add(zone_head, chunk->size);
+    stats_used_add(zone_head, second->size);
+    return second;
+}
+
+/**
+ * @brief Round a medium size so that the chunk, metadata included, spans a
+ * whole number of pages. Other sizes are returned unchanged.
+ * @param size The aligned size requested
+ * @return The size of the chunk to allocate
+ */
+size_t chunk_round_size(size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    if (size <= memory_g.small_max || size > memory_g.large_threshold) {
+        return size;
+    }
+    size += CHUNK_METADATA_SIZE + page_size - 1;
+    return size - size % page_size - CHUNK_METADATA_SIZE;
+}
+
 void chunk_init(chunk_t chunk, size_t size) {
     chunk->size = size;
     chunk->next = NULL;
     chunk->prev = NULL;
     chunk->magic = 0;
-    chunk->magic |= MAGIC_SERIALIZE((uintptr_t)chunk->data);
+    chunk->magic |= MAGIC_SERIALIZE(chunk_magic(chunk));
     chunk->free = 0;
 }
 
@@ -69,21 +361,21 @@ chunk_t chunk_new(size_t size) {
 }
 
 /**
- * @brief Push a chunk to the back of the chunk linked list
- * @param head the head of the linked list
- * @param chunk the chunk to push back
+ * @brief Raise the zone/mmap threshold when a large chunk is freed soon after
+ * it was allocated, so that the next allocations of this size don't need a
+ * syscall. The threshold never goes above the large_threshold_max of the
+ * heap configuration.
+ * @param chunk The large chunk being freed
+ * @param birth The tick when \a chunk was mapped
  */
-void chunk_push_back(chunk_t *head, chunk_t chunk) {
-    chunk_t it = *head;
-    if (*head == NULL) {
-        *head = chunk;
+void chunk_large_threshold_update(chunk_t chunk, size_t birth) {
+    if (chunk->size <= memory_g.large_threshold
+        || chunk->size > memory_g.config->large_threshold_max) {
         return;
     }
-    while (it->next) {
-        it = it->next;
+    if (memory_g.tick - birth <= memory_g.config->large_threshold_window) {
+        memory_g.large_threshold = chunk->size;
     }
-    it->next = chunk;
-    chunk->prev = it;
 }
 
 /**
@@ -101,8 +393,15 @@ chunk_t chunk_search(chunk_t c_head, size_t size) {
 
 chunk_t  chunk_validate(void *addr, zone_t *zone, zone_t **zone_head) {
     chunk_t chunk = (chunk_t)(addr - CHUNK_METADATA_SIZE);
-    uintptr_t magic;
-    uintptr_t data;
+
+    //large chunks are found in constant time
+    if (registry_search(&memory_g.large, chunk) != NULL) {
+        if (zone_head) {
+            *zone_head = NULL;
+        }
+        *zone = NULL;
+        return HARDENING_CHECK && !chunk_check(chunk) ? NULL : chunk;
+    }
     //we check if the address is in a tiny zone
     if (zone_head) {
         *zone_head = &memory_g.tiny_head;
@@ -115,14 +414,69 @@ chunk_t  chunk_validate(void *addr, zone_t *zone, zone_t **zone_head) {
         }
         *zone = zone_validate((uintptr_t)addr, memory_g.small_head);
     }
+    if (*zone == NULL) {
+        if (zone_head) {
+            *zone_head = &memory_g.medium_head;
+        }
+        *zone = zone_validate((uintptr_t)addr, memory_g.medium_head);
+    }
+    if (*zone == NULL) {
+        return NULL;
+    }
+    return HARDENING_CHECK && !chunk_check(chunk) ? NULL : chunk;
+}
+
+/**
+ * @brief Check that the magic stored in \a chunk matches its data address,
+ * and its size when built with MALLOC_HARDENING_HARDENED
+ * @param chunk The chunk to check
+ * @return true if it's very likely that \a chunk is a correct chunk
+ */
+bool chunk_check(chunk_t chunk) {
+    uintptr_t magic;
+    uintptr_t data;
 
     // we deserialize chunk->magic to remove chunk->free
     magic = MAGIC_DESERIALIZE(chunk->magic);
     // we serialize and deserialize chunk->data to reproduce the same process magic goes though
-    data = MAGIC_DESERIALIZE(MAGIC_SERIALIZE((uintptr_t)chunk->data));
+    data = MAGIC_DESERIALIZE(MAGIC_SERIALIZE(chunk_magic(chunk)));
 
     //now if they match it's very likely that the address given is a correct chunk
-    return magic == data ? chunk : NULL;
+    return magic == data;
+}
+
+/**
+ * @brief Account a new free chunk in the stats, and index it for best-fit
+ * search when it belongs to a small zone and MALLOC_BEST_FIT is set
+ * @param zone_head The head of the zone list containing \a chunk
+ * @param zone The zone containing \a chunk, kept in its node
+ * @param chunk The free chunk
+ */
+void chunk_tree_insert(zone_t *zone_head, zone_t zone, chunk_t chunk) {
+    stats_free_add(zone_head, chunk->size);
+#ifdef MALLOC_BEST_FIT
+    if (zone_head == &memory_g.small_head && chunk->size >= TREE_MIN_SIZE) {
+        tree_insert(&memory_g.small_tree, chunk);
+        TREE_SET_ZONE(chunk, zone);
+    }
+#else
+    (void)zone;
+#endif
+}
+
+/**
+ * @brief Remove a free chunk from the stats and the best-fit index, must be
+ * called before its size is changed
+ * @param zone_head The head of the zone list containing \a chunk
+ * @param chunk The free chunk
+ */
+void chunk_tree_remove(zone_t *zone_head, chunk_t chunk) {
+    stats_free_remove(zone_head, chunk->size);
+#ifdef MALLOC_BEST_FIT
+    if (zone_head == &memory_g.small_head && chunk->size >= TREE_MIN_SIZE) {
+        tree_remove(&memory_g.small_tree, chunk);
+    }
+#endif
 }
 
 /**
@@ -145,39 +499,92 @@ chunk_t chunk_split(chunk_t chunk, size_t size) {
     new_chunk->next = chunk->next;
     new_chunk->prev = chunk;
     new_chunk->free = 1;
+    chunk_seal(new_chunk);
     if (new_chunk->next) {
         new_chunk->next->prev = new_chunk;
+        chunk_seal(new_chunk->next);
     }
     chunk->size = size;
     chunk->next = new_chunk;
+    chunk_seal(chunk);
     return new_chunk;
 }
 
+/**
+ * @brief Check whether the neighbour of a chunk can be merged into it: it's
+ * free, and when built with MALLOC_HARDENING_HARDENED its header is intact,
+ * so that its links are never followed after an overflow rewrote them
+ * @param neighbour The next or previous chunk, may be NULL
+ */
+bool chunk_fusable(chunk_t neighbour) {
+#ifdef MALLOC_HARDENING_HARDENED
+    return neighbour && neighbour->free && chunk_check(neighbour);
+#else
+    return neighbour && neighbour->free;
+#endif
+}
+
 void chunk_fusion(chunk_t chunk) {
     chunk_fusion_next(chunk);
     chunk_fusion_prev(chunk);
 }
 
 void chunk_fusion_next(chunk_t chunk) {
-    if (chunk->next && chunk->next->free) {
+    if (chunk_fusable(chunk->next)) {
         chunk->size += CHUNK_METADATA_SIZE + chunk->next->size;
         chunk->next = chunk->next->next;
+        chunk_seal(chunk);
         if (chunk->next) {
             chunk->next->prev = chunk;
+            chunk_seal(chunk->next);
         }
     }
 }
 
 void chunk_fusion_prev(chunk_t chunk) {
-    if (chunk->prev && chunk->prev->free) {
+    if (chunk_fusable(chunk->prev)) {
         chunk->prev->size += CHUNK_METADATA_SIZE + chunk->size;
         chunk->prev->next = chunk->next;
+        chunk_seal(chunk->prev);
         if (chunk->next) {
             chunk->next->prev = chunk->prev;
+            chunk_seal(chunk->next);
         }
     }
 }
 
+/**
+ * @brief Compute the value stored in the magic of \a chunk
+ * @param chunk The chunk, its size and links must be set
+ * @return The data address, mixed with the size, the links and the process
+ * secret when built with MALLOC_HARDENING_HARDENED
+ */
+static inline uintptr_t chunk_magic(chunk_t chunk) {
+#ifdef MALLOC_HARDENING_HARDENED
+    return (uintptr_t)chunk->data ^ hardening_secret() ^ (chunk->size * 0x9E3779B97F4A7C15)
+        ^ ((uintptr_t)chunk->next * 0xC2B2AE3D27D4EB4F) ^ ((uintptr_t)chunk->prev * 0x165667B19E3779F9);
+#else
+    return (uintptr_t)chunk->data;
+#endif
+}
+
+/**
+ * @brief Update the magic after the size or the links of \a chunk changed,
+ * keeping its free flag. The magic doesn't depend on them unless built with
+ * MALLOC_HARDENING_HARDENED.
+ * @param chunk The resized or relinked chunk
+ */
+void chunk_seal(chunk_t chunk) {
+#ifdef MALLOC_HARDENING_HARDENED
+    const uint8_t free = chunk->free;
+
+    chunk->magic = MAGIC_SERIALIZE(chunk_magic(chunk));
+    chunk->free = free;
+#else
+    (void)chunk;
+#endif
+}
+
 void chunk_copy(chunk_t src, chunk_t dst) {
     size_t align_size = ALIGN_SIZE;
 
@@ -0,0 +1,157 @@
+#include "class.h"
+
+#include <unistd.h>
+
+#include "memory.h"
+#include "quick.h"
+#include "zone.h"
+
+#define CLASS_SMALL_SLOTS   (CLASS_SMALL_MAX / CLASS_SMALL_STEP + 1)
+
+/**
+ * Running sums of the histogram up to each candidate boundary
+ */
+typedef struct {
+    uint64_t    small_count[CLASS_SMALL_SLOTS]; // Requests up to each small boundary
+    uint64_t    small_waste[CLASS_SMALL_SLOTS]; // Their page rounding, were they medium
+    uint64_t    tiny_count;                     // Requests served by the tiny class
+    uint64_t    waste;                          // Page rounding of every request
+} class_sums_t;
+
+static uint64_t class_cost(const class_sums_t *sums, size_t small_max);
+static uint64_t class_waste(const class_sums_t *sums, size_t small_max);
+static size_t   class_medium_waste(size_t size, size_t page_size);
+
+/**
+ * @brief Count a request in the histogram of the heap of the calling thread,
+ * and tune its boundaries every CLASS_TUNE_PERIOD requests. Does nothing
+ * unless the heap was configured with adaptive_classes.
+ * The caller must hold the memory lock.
+ * @param requested The size asked by the caller, before alignment
+ */
+void class_record(size_t requested) {
+    class_t *class = &memory_g.classes;
+
+    if (!memory_g.config->adaptive_classes) {
+        return;
+    }
+    if (requested != 0 && requested <= CLASS_SMALL_MAX) {
+        class->counts[ALIGN_MEM(requested) / ALIGN_SIZE - 1]++;
+    }
+    if (++class->samples >= CLASS_TUNE_PERIOD) {
+        class_tune();
+    }
+}
+
+/**
+ * @brief Move the small boundary to the one that wastes the least for the
+ * sizes seen. Tiny and small chunks are split to the exact size, so only two
+ * costs depend on it: the page rounding of the requests left to the medium
+ * class, and the mapping of a small zone, which grows with the boundary. The
+ * tiny boundary doesn't change either, so it isn't tuned. Zones mapped from
+ * now on use the new boundary, the others keep serving what fits in them.
+ * The caller must hold the memory lock.
+ */
+void class_tune(void) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    class_t *class = &memory_g.classes;
+    size_t small_limit = memory_g.config->large_threshold_min;
+    class_sums_t sums;
+    uint64_t count = 0;
+    uint64_t current;
+    uint64_t best;
+    uint64_t cost;
+    size_t best_small = memory_g.small_max;
+    size_t size;
+
+    class->samples = 0;
+    sums.waste = 0;
+    sums.tiny_count = 0;
+    for (size_t i = 0; i < CLASS_BUCKET_COUNT; i++) {
+        size = (i + 1) * ALIGN_SIZE;
+        count += class->counts[i];
+        sums.waste += (uint64_t)class->counts[i] * class_medium_waste(size, page_size);
+        if (size <= memory_g.tiny_max) {
+            sums.tiny_count = count;
+        }
+        if (size % CLASS_SMALL_STEP == 0) {
+            sums.small_count[size / CLASS_SMALL_STEP] = count;
+            sums.small_waste[size / CLASS_SMALL_STEP] = sums.waste;
+        }
+        class->counts[i] /= 2;
+    }
+    if (count == 0) {
+        return;
+    }
+    //The small class can't reach into the medium one
+    if (small_limit > CLASS_SMALL_MAX) {
+        small_limit = CLASS_SMALL_MAX;
+    }
+    small_limit -= small_limit % CLASS_SMALL_STEP;
+    current = class_cost(&sums, memory_g.small_max);
+    best = current;
+    for (size_t small_max = CLASS_SMALL_MIN; small_max <= small_limit; small_max += CLASS_SMALL_STEP) {
+        cost = class_cost(&sums, small_max);
+        if (cost < best) {
+            best = cost;
+            best_small = small_max;
+        }
+    }
+    if (current - best <= current / CLASS_TUNE_GAIN) {
+        return;
+    }
+#ifdef MALLOC_QUICK_LIST
+    //Quick lists are matched to their class by size
+    quick_flush(NULL);
+#endif
+    cost = class_waste(&sums, memory_g.small_max);
+    best = class_waste(&sums, best_small);
+    class->saved = cost > best ? (cost - best) * CLASS_TUNE_PERIOD / count : 0;
+    memory_g.small_max = best_small;
+    class->tunings++;
+}
+
+/**
+ * @brief Get the boundaries of the heap of the calling thread, and what their
+ * last move is estimated to save
+ * @param info Filled with the boundaries and the estimate
+ */
+void class_get(class_info_t *info) {
+    memory_lock();
+    info->tiny_max = memory_g.tiny_max;
+    info->small_max = memory_g.small_max;
+    info->tunings = memory_g.classes.tunings;
+    info->saved = memory_g.classes.saved;
+    memory_unlock();
+}
+
+/**
+ * @brief Get the bytes wasted by the requests of the histogram with the
+ * small boundary \a small_max, which must be a candidate: their page
+ * rounding, and the smallest small zone when the class serves any of them
+ */
+static uint64_t class_cost(const class_sums_t *sums, size_t small_max) {
+    uint64_t cost = class_waste(sums, small_max);
+
+    if (sums->small_count[small_max / CLASS_SMALL_STEP] > sums->tiny_count) {
+        cost += small_max * CHUNK_PER_ZONE + ZONE_METADATA_SIZE;
+    }
+    return cost;
+}
+
+/**
+ * @brief Get the page rounding of the requests of the histogram left to the
+ * medium class by the small boundary \a small_max
+ */
+static uint64_t class_waste(const class_sums_t *sums, size_t small_max) {
+    return sums->waste - sums->small_waste[small_max / CLASS_SMALL_STEP];
+}
+
+/**
+ * @brief Get the bytes lost to page rounding by a medium chunk of \a size bytes
+ */
+static size_t class_medium_waste(size_t size, size_t page_size) {
+    const size_t rounded = size + CHUNK_METADATA_SIZE + page_size - 1;
+
+    return rounded - rounded % page_size - CHUNK_METADATA_SIZE - size;
+}
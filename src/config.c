@@ -0,0 +1,91 @@
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "chunk.h"
+#include "def.h"
+#include "latency.h"
+#include "maintenance.h"
+#include "memory.h"
+#include "profile.h"
+
+static size_t config_get(const char *name, size_t default_value);
+
+config_t config_g = {
+    .large_threshold_min = CONFIG_LARGE_THRESHOLD_MIN,
+    .large_threshold_max = CONFIG_LARGE_THRESHOLD_MAX,
+    .large_threshold_window = CONFIG_LARGE_THRESHOLD_WINDOW,
+    .background = 0,
+    .decay_ms = CONFIG_DECAY_MS,
+    .limit = 0,
+    .prefault = 0,
+    .prefault_large_max = 0,
+    .pregrow = 0,
+    .latency = 0,
+    .adaptive_classes = 0,
+    .profile = NULL,
+};
+
+/**
+ * @brief Load the configuration from the environment. Called before main, but
+ * allocations made earlier simply use the defaults.
+ */
+__attribute__((constructor))
+void config_init(void) {
+    memory_atfork();
+    config_g.large_threshold_min = config_get(CONFIG_ENV_LARGE_THRESHOLD_MIN, CONFIG_LARGE_THRESHOLD_MIN);
+    config_g.large_threshold_max = config_get(CONFIG_ENV_LARGE_THRESHOLD_MAX, CONFIG_LARGE_THRESHOLD_MAX);
+    config_g.large_threshold_window = config_get(CONFIG_ENV_LARGE_THRESHOLD_WINDOW, CONFIG_LARGE_THRESHOLD_WINDOW);
+    config_g.background = config_get(CONFIG_ENV_BACKGROUND, 0);
+    config_g.decay_ms = config_get(CONFIG_ENV_DECAY_MS, CONFIG_DECAY_MS);
+    config_g.limit = config_get(CONFIG_ENV_LIMIT, 0);
+    config_g.prefault = config_get(CONFIG_ENV_PREFAULT, 0);
+    config_g.prefault_large_max = config_get(CONFIG_ENV_PREFAULT_LARGE_MAX, 0);
+    config_g.pregrow = config_get(CONFIG_ENV_PREGROW, 0);
+    config_g.latency = config_get(CONFIG_ENV_LATENCY, 0);
+    config_g.adaptive_classes = config_get(CONFIG_ENV_ADAPTIVE_CLASSES, 0);
+    config_g.profile = getenv(CONFIG_ENV_PROFILE);
+    if (config_g.profile != NULL && *config_g.profile == '\0') {
+        config_g.profile = NULL;
+    }
+    config_clamp(&config_g);
+    memory_lock();
+    memory_g.large_threshold = ALIGN_MEM(config_g.large_threshold_min);
+    memory_unlock();
+    if (config_g.background || config_g.pregrow) {
+        maintenance_start();
+    }
+    if (config_g.latency) {
+        latency_enable(true);
+    }
+    profile_init();
+}
+
+/**
+ * @brief Bring the thresholds of \a config back to values the zones can serve
+ * @param config The configuration to fix
+ */
+void config_clamp(config_t *config) {
+    //Below SMALL_CHUNK_SIZE the medium class would be empty
+    if (config->large_threshold_min < SMALL_CHUNK_SIZE) {
+        config->large_threshold_min = SMALL_CHUNK_SIZE;
+    }
+    if (config->large_threshold_max < config->large_threshold_min) {
+        config->large_threshold_max = config->large_threshold_min;
+    }
+}
+
+static size_t config_get(const char *name, size_t default_value) {
+    const char *value = getenv(name);
+    char *end;
+    size_t ret;
+
+    if (value == NULL || *value == '\0') {
+        return default_value;
+    }
+    ret = strtoul(value, &end, 10);
+    if (*end != '\0') {
+        return default_value;
+    }
+    return ret;
+}
@@ -8,6 +8,7 @@
 #include "memory.h"
 #include "chunk.h"
 #include "zone.h"
+#include "stats.h"
 
 #define HEXDUMP_WORD_SIZE 16
 
@@ -15,6 +16,7 @@ static void zone_display_memory(zone_t zone);
 static void chunk_display_memory(chunk_t chunk);
 static void zone_display_memory_ex(zone_t zone);
 static void chunk_display_memory_ex(chunk_t chunk);
+static void stats_display(const char *name, stats_class_t class, zone_t zone);
 static void hexdump(void* addr, size_t size);
 static void hexdump_print_hex(uint8_t *data);
 static void hexdump_print_ascii(uint8_t *data);
@@ -29,9 +31,17 @@ void display_memory(void) {
         printf("SMALL: %p\n", memory_g.small_head->data);
         zone_display_memory(memory_g.small_head);
     }
-    if (memory_g.large_head) {
-        printf("LARGE : %p\n", memory_g.large_head);
-        chunk_display_memory(memory_g.large_head);
+    if (memory_g.medium_head) {
+        printf("MEDIUM: %p\n", memory_g.medium_head->data);
+        zone_display_memory(memory_g.medium_head);
+    }
+    if (memory_g.large.count) {
+        printf("LARGE :\n");
+        for (size_t i = 0; i < memory_g.large.capacity; i++) {
+            if (memory_g.large.entries[i].chunk) {
+                chunk_display_memory(memory_g.large.entries[i].chunk);
+            }
+        }
     }
     printf("--------------------\n");
 }
@@ -63,9 +73,55 @@ void display_memory_ex(void) {
         printf("--------------- SMALL HEAD ---------------\n");
         zone_display_memory_ex(memory_g.small_head);
     }
-    if (memory_g.large_head) {
+    if (memory_g.medium_head) {
+        printf("--------------- MEDIUM HEAD ---------------\n");
+        zone_display_memory_ex(memory_g.medium_head);
+    }
+    if (memory_g.large.count) {
         printf("--------------- CHUNK HEAD ---------------\n");
-        chunk_display_memory_ex(memory_g.large_head);
+        for (size_t i = 0; i < memory_g.large.capacity; i++) {
+            if (memory_g.large.entries[i].chunk) {
+                chunk_display_memory_ex(memory_g.large.entries[i].chunk);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Print the utilization and fragmentation of every class. The counters
+ * are maintained incrementally, only the zone headers are walked.
+ */
+void display_stats(void) {
+    stats_display("TINY", STATS_TINY, memory_g.tiny_head);
+    stats_display("SMALL", STATS_SMALL, memory_g.small_head);
+    stats_display("MEDIUM", STATS_MEDIUM, memory_g.medium_head);
+    stats_display("LARGE", STATS_LARGE, NULL);
+}
+
+static void stats_display(const char *name, stats_class_t class, zone_t zone) {
+    stats_t stats;
+    size_t low;
+
+    stats_get(class, &stats);
+    printf("--------------- %s STATS ---------------\n", name);
+    printf("zones: %zu, mapped: %zu bytes\n", stats.zone_count, stats.mapped);
+    printf("used: %zu chunks, %zu bytes, %zu header bytes\n",
+           stats.used_count, stats.used_size, stats.used_count * CHUNK_METADATA_SIZE);
+    printf("free: %zu chunks, %zu bytes, largest %zu bytes\n",
+           stats.free_count, stats.free_size, stats_max_free(class));
+    printf("external fragmentation: %.1f%%\n", stats_external_fragmentation(class) * 100);
+    printf("internal fragmentation: %.1f%% (%zu bytes requested, %zu bytes granted)\n",
+           stats_internal_fragmentation(class) * 100, stats.requested, stats.granted);
+    for (size_t i = 0; i < STATS_BUCKET_COUNT; i++) {
+        if (stats.free_histogram[i]) {
+            low = (size_t)1 << i;
+            printf("free [%zu, %zu): %zu\n", low, low * 2, stats.free_histogram[i]);
+        }
+    }
+    while (zone) {
+        printf("zone %p: %.1f%% used, largest free <= %zu bytes\n", zone,
+               (1 - (double)zone->free_size / zone->size) * 100, zone->max_free);
+        zone = zone->next;
     }
 }
 
@@ -74,6 +130,8 @@ static void zone_display_memory_ex(zone_t zone) {
         printf("[ZONE %p]\n", zone);
         printf(".size: %zu (0x%zx)\n", zone->size, zone->size);
         printf(".next: %p\n", zone->next);
+        printf(".free_size: %zu\n", zone->free_size);
+        printf(".max_free: %zu\n", zone->max_free);
         printf(".data: %p\n", zone->data);
         hexdump(zone, ZONE_METADATA_SIZE);
         chunk_display_memory_ex(zone_get_chunk(zone));
@@ -0,0 +1,370 @@
+#include "dump.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "chunk.h"
+#include "memory.h"
+#include "stats.h"
+#include "zone.h"
+#include "snapshot.h"
+
+/**
+ * Output is buffered on the stack and flushed with write(), so dumping never
+ * allocates nor touches stdio.
+ */
+typedef struct {
+    int     fd;
+    size_t  len;
+    bool    error;
+    char    data[DUMP_BUFFER_SIZE];
+} dump_buffer_t;
+
+static bool dump_lock(void);
+static void dump_signal_handler(int signum);
+static void dump_zones(dump_buffer_t *buf, const char *name, zone_t zone, bool *first);
+static void dump_stats(dump_buffer_t *buf);
+static void dump_large(dump_buffer_t *buf);
+static void dump_snapshot_zones(dump_buffer_t *buf, stats_class_t class, zone_t zone);
+static void dump_snapshot_record(dump_buffer_t *buf, snapshot_type_t type, uint8_t class,
+                                 bool free, const void *address, size_t size);
+static void dump_bytes(dump_buffer_t *buf, const void *data, size_t size);
+static void dump_str(dump_buffer_t *buf, const char *str);
+static void dump_number(dump_buffer_t *buf, size_t n);
+static void dump_address(dump_buffer_t *buf, const void *addr);
+static void dump_char(dump_buffer_t *buf, char c);
+static void dump_flush(dump_buffer_t *buf);
+
+static const char   *dump_class_names_g[STATS_CLASS_COUNT] = {"tiny", "small", "medium", "large"};
+static int          dump_fd_g = -1;
+
+/**
+ * @brief Write the zones, chunks, large mappings and stats as a single line of
+ * JSON. Only write() and stack memory are used, so this is async-signal-safe.
+ * If the memory lock is held, e.g. by the interrupted thread itself, nothing
+ * is written. errno is only changed on failure, a signal handler calling it
+ * must save errno around the call, as dump_signal does.
+ * @param fd The file descriptor to write to
+ * @return 0 on success, -1 if the lock couldn't be taken or a write failed
+ */
+int dump_memory(int fd) {
+    dump_buffer_t buf;
+    bool first = true;
+    const int saved_errno = errno;
+
+    buf.fd = fd;
+    buf.len = 0;
+    buf.error = false;
+    if (!dump_lock()) {
+        errno = EBUSY;
+        return -1;
+    }
+    dump_str(&buf, "{\"large_threshold\":");
+    dump_number(&buf, memory_g.large_threshold);
+    dump_str(&buf, ",\"tick\":");
+    dump_number(&buf, memory_g.tick);
+    dump_str(&buf, ",\"stats\":");
+    dump_stats(&buf);
+    dump_str(&buf, ",\"zones\":[");
+    dump_zones(&buf, dump_class_names_g[STATS_TINY], memory_g.tiny_head, &first);
+    dump_zones(&buf, dump_class_names_g[STATS_SMALL], memory_g.small_head, &first);
+    dump_zones(&buf, dump_class_names_g[STATS_MEDIUM], memory_g.medium_head, &first);
+    dump_str(&buf, "],\"large\":");
+    dump_large(&buf);
+    dump_str(&buf, "}\n");
+    memory_unlock();
+    dump_flush(&buf);
+    if (buf.error) {
+        return -1;
+    }
+    errno = saved_errno;
+    return 0;
+}
+
+/**
+ * @brief Dump the memory to \a fd whenever \a signum is received, e.g. SIGUSR2
+ * @param signum The signal to handle
+ * @param fd The file descriptor to write to, must stay open
+ * @return 0 on success, -1 if the handler couldn't be installed
+ */
+int dump_signal(int signum, int fd) {
+    struct sigaction action = {0};
+
+    dump_fd_g = fd;
+    action.sa_handler = dump_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(signum, &action, NULL);
+}
+
+/**
+ * @brief Write a binary snapshot of every zone, chunk and large mapping, in
+ * the format described in snapshot.h. Async-signal-safe like dump_memory,
+ * and like it, sets errno on failure only.
+ * @param fd The file descriptor to write to
+ * @return 0 on success, -1 if the lock couldn't be taken or a write failed
+ */
+int dump_snapshot(int fd) {
+    const int saved_errno = errno;
+    snapshot_header_t header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .page_size = sysconf(_SC_PAGESIZE),
+    };
+    const registry_entry_t *entry;
+    dump_buffer_t buf;
+
+    buf.fd = fd;
+    buf.len = 0;
+    buf.error = false;
+    if (!dump_lock()) {
+        errno = EBUSY;
+        return -1;
+    }
+    header.tick = memory_g.tick;
+    header.large_threshold = memory_g.large_threshold;
+    header.tiny_max = memory_g.tiny_max;
+    header.small_max = memory_g.small_max;
+    dump_bytes(&buf, &header, sizeof(header));
+    dump_snapshot_zones(&buf, STATS_TINY, memory_g.tiny_head);
+    dump_snapshot_zones(&buf, STATS_SMALL, memory_g.small_head);
+    dump_snapshot_zones(&buf, STATS_MEDIUM, memory_g.medium_head);
+    for (size_t i = 0; i < memory_g.large.capacity; i++) {
+        entry = &memory_g.large.entries[i];
+        if (entry->chunk != NULL) {
+            dump_snapshot_record(&buf, SNAPSHOT_LARGE, STATS_LARGE, false, entry->chunk, entry->size);
+        }
+    }
+    dump_snapshot_record(&buf, SNAPSHOT_END, 0, false, NULL, 0);
+    memory_unlock();
+    dump_flush(&buf);
+    if (buf.error) {
+        return -1;
+    }
+    errno = saved_errno;
+    return 0;
+}
+
+/**
+ * @brief Write a binary snapshot to a new file, replacing \a path
+ * @param path The path of the snapshot file
+ * @return 0 on success, -1 on failure
+ */
+int dump_snapshot_file(const char *path) {
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ret;
+
+    if (fd == -1) {
+        return -1;
+    }
+    ret = dump_snapshot(fd);
+    if (close(fd) == -1) {
+        ret = -1;
+    }
+    return ret;
+}
+
+/**
+ * @brief Dump the memory, leaving errno as the interrupted code had it: the
+ * dump fails with EBUSY whenever the signal lands while the lock is held
+ */
+static void dump_signal_handler(int signum) {
+    const int saved_errno = errno;
+
+    (void)signum;
+    dump_memory(dump_fd_g);
+    errno = saved_errno;
+}
+
+/**
+ * @brief Take the memory lock without waiting: when the signal interrupted
+ * the thread holding it, waiting would deadlock, and sleeping in a signal
+ * handler would stall the interrupted thread
+ * @return true if the lock is held
+ */
+static bool dump_lock(void) {
+    return pthread_mutex_trylock(&memory_g.lock) == 0;
+}
+
+/**
+ * @brief Chunks are written as [offset in the zone, size, free]
+ */
+static void dump_zones(dump_buffer_t *buf, const char *name, zone_t zone, bool *first) {
+    chunk_t chunk;
+
+    for (; zone; zone = zone->next) {
+        dump_str(buf, *first ? "{\"class\":\"" : ",{\"class\":\"");
+        *first = false;
+        dump_str(buf, name);
+        dump_str(buf, "\",\"address\":");
+        dump_address(buf, zone);
+        dump_str(buf, ",\"size\":");
+        dump_number(buf, zone->size);
+        dump_str(buf, ",\"free_size\":");
+        dump_number(buf, zone->free_size);
+        dump_str(buf, ",\"max_free\":");
+        dump_number(buf, zone->max_free);
+        dump_str(buf, ",\"chunks\":[");
+        for (chunk = zone_get_chunk(zone); chunk; chunk = chunk->next) {
+            dump_str(buf, chunk == zone_get_chunk(zone) ? "[" : ",[");
+            dump_number(buf, (uintptr_t)chunk - (uintptr_t)zone->data);
+            dump_char(buf, ',');
+            dump_number(buf, chunk->size);
+            dump_str(buf, chunk->free ? ",1]" : ",0]");
+        }
+        dump_str(buf, "]}");
+    }
+}
+
+static void dump_stats(dump_buffer_t *buf) {
+    const stats_t *stats;
+
+    dump_char(buf, '{');
+    for (size_t i = 0; i < STATS_CLASS_COUNT; i++) {
+        stats = &memory_g.stats[i];
+        dump_str(buf, i ? ",\"" : "\"");
+        dump_str(buf, dump_class_names_g[i]);
+        dump_str(buf, "\":{\"zones\":");
+        dump_number(buf, stats->zone_count);
+        dump_str(buf, ",\"mapped\":");
+        dump_number(buf, stats->mapped);
+        dump_str(buf, ",\"used_count\":");
+        dump_number(buf, stats->used_count);
+        dump_str(buf, ",\"used_size\":");
+        dump_number(buf, stats->used_size);
+        dump_str(buf, ",\"free_count\":");
+        dump_number(buf, stats->free_count);
+        dump_str(buf, ",\"free_size\":");
+        dump_number(buf, stats->free_size);
+        dump_str(buf, ",\"requested\":");
+        dump_number(buf, stats->requested);
+        dump_str(buf, ",\"granted\":");
+        dump_number(buf, stats->granted);
+        dump_char(buf, '}');
+    }
+    dump_char(buf, '}');
+}
+
+/**
+ * @brief Large mappings are written as [address, mapping size, birth tick]
+ */
+static void dump_large(dump_buffer_t *buf) {
+    const registry_entry_t *entry;
+    bool first = true;
+
+    dump_char(buf, '[');
+    for (size_t i = 0; i < memory_g.large.capacity; i++) {
+        entry = &memory_g.large.entries[i];
+        if (entry->chunk == NULL) {
+            continue;
+        }
+        dump_str(buf, first ? "[" : ",[");
+        first = false;
+        dump_address(buf, entry->chunk);
+        dump_char(buf, ',');
+        dump_number(buf, entry->size);
+        dump_char(buf, ',');
+        dump_number(buf, entry->birth);
+        dump_char(buf, ']');
+    }
+    dump_char(buf, ']');
+}
+
+static void dump_snapshot_zones(dump_buffer_t *buf, stats_class_t class, zone_t zone) {
+    for (; zone; zone = zone->next) {
+        dump_snapshot_record(buf, SNAPSHOT_ZONE, class, false, zone, zone->size);
+        for (chunk_t chunk = zone_get_chunk(zone); chunk; chunk = chunk->next) {
+            dump_snapshot_record(buf, SNAPSHOT_CHUNK, class, chunk->free, chunk, chunk->size);
+        }
+    }
+}
+
+static void dump_snapshot_record(dump_buffer_t *buf, snapshot_type_t type, uint8_t class,
+                                 bool free, const void *address, size_t size) {
+    const snapshot_record_t record = {
+        .type = type,
+        .class = class,
+        .free = free,
+        .address = (uintptr_t)address,
+        .size = size,
+    };
+
+    dump_bytes(buf, &record, sizeof(record));
+}
+
+static void dump_bytes(dump_buffer_t *buf, const void *data, size_t size) {
+    const char *bytes = data;
+
+    for (size_t i = 0; i < size; i++) {
+        dump_char(buf, bytes[i]);
+    }
+}
+
+static void dump_str(dump_buffer_t *buf, const char *str) {
+    while (*str) {
+        dump_char(buf, *str++);
+    }
+}
+
+static void dump_number(dump_buffer_t *buf, size_t n) {
+    char digits[20];
+    size_t len = 0;
+
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    while (len) {
+        dump_char(buf, digits[--len]);
+    }
+}
+
+/**
+ * @brief Addresses are written as hexadecimal strings, JSON numbers aren't
+ * reliably read beyond 2^53
+ */
+static void dump_address(dump_buffer_t *buf, const void *addr) {
+    const char *hex = "0123456789abcdef";
+    uintptr_t n = (uintptr_t)addr;
+    char digits[sizeof(uintptr_t) * 2];
+    size_t len = 0;
+
+    do {
+        digits[len++] = hex[n % 16];
+        n /= 16;
+    } while (n);
+    dump_str(buf, "\"0x");
+    while (len) {
+        dump_char(buf, digits[--len]);
+    }
+    dump_char(buf, '"');
+}
+
+static void dump_char(dump_buffer_t *buf, char c) {
+    if (buf->len == DUMP_BUFFER_SIZE) {
+        dump_flush(buf);
+    }
+    buf->data[buf->len++] = c;
+}
+
+static void dump_flush(dump_buffer_t *buf) {
+    size_t written = 0;
+    ssize_t ret;
+
+    while (!buf->error && written < buf->len) {
+        ret = write(buf->fd, buf->data + written, buf->len - written);
+        if (ret == -1 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            buf->error = true;
+        } else {
+            written += ret;
+        }
+    }
+    buf->len = 0;
+}
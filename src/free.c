@@ -4,24 +4,163 @@
 #include <unistd.h>
 #include <sys/mman.h>
 
+#include "cache.h"
 #include "chunk.h"
 #include "zone.h"
+#include "def.h"
 #include "memory.h"
+#include "hardening.h"
+#include "latency.h"
+#include "limit.h"
+#include "maintenance.h"
+#include "quick.h"
+#include "stats.h"
 
 #define ERROR_INVALID_PTR_MSG "free(): invalid pointer\n"
 #define ERROR_INVALID_PTR_LEN 24
 #define ERROR_DOUBLE_FREE_MSG "free(): double free detected\n"
 #define ERROR_DOUBLE_FREE_LEN 29
 
+static void free_release(chunk_t chunk, zone_t zone, zone_t *zone_head);
+static zone_t *free_sized_head(size_t size);
+#ifdef MALLOC_CACHE
+static bool free_cache(void *ptr);
+#endif
+
 void free(void *ptr) {
+    uint64_t start;
+
+    if (ptr == NULL) {
+        return;
+    }
+    start = latency_start();
+#ifdef MALLOC_CACHE
+    //The lock is only taken when the chunk can't be cached
+    if (free_cache(ptr)) {
+        latency_end(LATENCY_FREE, start);
+        return;
+    }
+#endif
+    memory_lock();
+    free_ptr(ptr);
+    memory_unlock();
+    latency_end(LATENCY_FREE, start);
+}
+
+/**
+ * @brief Free \a ptr in the heap of the calling thread, see memory_g.
+ * The caller must hold the lock of that heap.
+ * @param ptr The pointer to free, not NULL
+ */
+void free_ptr(void *ptr) {
     chunk_t chunk;
     zone_t zone;
     zone_t *zone_head;
 
+    chunk = chunk_validate(ptr, &zone, &zone_head);
+    free_release(chunk, zone, zone_head);
+}
+
+/**
+ * @brief Free \a ptr knowing the size it was allocated with. The size only
+ * narrows the lookup, the zone isn't computed: zones aren't aligned, so it's
+ * still searched, but only in the zone list of the class of \a size, or in
+ * the large registry above the zones. The other classes are only searched
+ * when \a ptr isn't found there.
+ * @param ptr The pointer to free
+ * @param size The size given to malloc for \a ptr
+ */
+void free_sized(void *ptr, size_t size) {
+    chunk_t chunk;
+    zone_t zone = NULL;
+    zone_t *zone_head;
+
     if (ptr == NULL) {
         return;
     }
-    chunk = chunk_validate(ptr, &zone, &zone_head);
+#ifdef MALLOC_CACHE
+    if (free_cache(ptr)) {
+        return;
+    }
+#endif
+    chunk = (chunk_t)(ptr - CHUNK_METADATA_SIZE);
+    memory_lock();
+    zone_head = free_sized_head(ALIGN_MEM(size));
+    if (zone_head != NULL ? (zone = zone_validate((uintptr_t)ptr, *zone_head)) != NULL
+                          : registry_search(&memory_g.large, chunk) != NULL) {
+        chunk = HARDENING_CHECK && !chunk_check(chunk) ? NULL : chunk;
+    } else {
+        //Aligned or reallocated pointers may live in another class
+        chunk = chunk_validate(ptr, &zone, &zone_head);
+    }
+    free_release(chunk, zone, zone_head);
+    memory_unlock();
+}
+
+/**
+ * @brief Give a validated chunk back to its zone, or unmap it if it's a large
+ * chunk. The caller must hold the memory lock.
+ * @param chunk The chunk to free
+ * @param zone The zone containing \a chunk, NULL for a large chunk
+ * @param zone_head The head of the zone list containing \a zone
+ */
+void free_chunk(chunk_t chunk, zone_t zone, zone_t *zone_head) {
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    registry_entry_t *entry;
+    void *map;
+
+    if (zone == NULL) {
+        entry = registry_search(&memory_g.large, chunk);
+        stats_used_remove(NULL, chunk->size);
+        chunk->free = 1;
+        chunk_large_threshold_update(chunk, entry->birth);
+        //Aligned chunks don't start their mapping
+        map = (void*)((uintptr_t)chunk & ~(page_size - 1));
+        //A deferred mapping stays in the stats until it's unmapped
+        if (limit_pressure() || !maintenance_defer_unmap(map, entry->size)) {
+            stats_zone_remove(NULL, entry->size);
+            latency_mark(LATENCY_PATH_SYSCALL);
+            if (munmap(map, entry->size) == -1) {
+                perror("free: munmap");
+            }
+        }
+        registry_remove(&memory_g.large, entry);
+        return;
+    }
+    stats_used_remove(zone_head, chunk->size);
+    chunk->free = 1;
+    zone->free_size += chunk->size + CHUNK_METADATA_SIZE;
+    if (chunk_fusable(chunk->next)) {
+        chunk_tree_remove(zone_head, chunk->next);
+    }
+    if (chunk_fusable(chunk->prev)) {
+        chunk_tree_remove(zone_head, chunk->prev);
+        chunk_fusion(chunk);
+        chunk = chunk->prev;
+    } else {
+        chunk_fusion(chunk);
+    }
+    chunk_tree_insert(zone_head, zone, chunk);
+    if (chunk->size > zone->max_free) {
+        zone->max_free = chunk->size;
+    }
+    if (limit_pressure()) {
+        //Close to the limit, no empty zone is kept
+        zone_trim(zone_head);
+    } else if (!maintenance_defer_zone(zone_head, zone)) {
+        zone_unmap(zone_head);
+    }
+}
+
+/**
+ * @brief Report an invalid pointer or a double free, free \a chunk otherwise.
+ * The caller must hold the memory lock.
+ * @param chunk The chunk found by the caller, NULL if none was
+ * @param zone The zone containing \a chunk, NULL for a large chunk
+ * @param zone_head The head of the zone list containing \a zone
+ */
+static void free_release(chunk_t chunk, zone_t zone, zone_t *zone_head) {
+#if HARDENING_CHECK
     if (chunk == NULL) {
         write(STDERR_FILENO, ERROR_INVALID_PTR_MSG, ERROR_INVALID_PTR_LEN);
         return;
@@ -30,24 +169,75 @@ void free(void *ptr) {
         write(STDERR_FILENO, ERROR_DOUBLE_FREE_MSG, ERROR_DOUBLE_FREE_LEN);
         return;
     }
-    if (zone == NULL) {
-        if (chunk == memory_g.large_head) {
-            memory_g.large_head = chunk->next;
-        }
-        if (chunk->prev) {
-            chunk->prev->next = chunk->next;
-        }
-        if (chunk->next) {
-            chunk->next->prev = chunk->prev;
-        }
-        chunk->free = 1;
-        if (munmap(chunk, chunk->size + CHUNK_METADATA_SIZE) == -1) {
-            perror("free: munmap");
-        }
+# ifdef MALLOC_CACHE
+    //Cached chunks are still marked used
+    if (cache_contains(chunk)) {
+        write(STDERR_FILENO, ERROR_DOUBLE_FREE_MSG, ERROR_DOUBLE_FREE_LEN);
         return;
     }
-    chunk->free = 1;
-    chunk_fusion(chunk);
-    zone_unmap(zone_head);
+# endif
+# ifdef MALLOC_QUICK_LIST
+    //Chunks in the quick lists are still marked used
+    if (quick_contains(chunk)) {
+        write(STDERR_FILENO, ERROR_DOUBLE_FREE_MSG, ERROR_DOUBLE_FREE_LEN);
+        return;
+    }
+# endif
+#else
+    //The caller is trusted, the lookup can only fail on a foreign pointer
+    if (chunk == NULL) {
+        return;
+    }
+#endif
+#ifdef MALLOC_QUICK_LIST
+    if (quick_push(chunk, zone, zone_head)) {
+        return;
+    }
+#endif
+    free_chunk(chunk, zone, zone_head);
 }
 
+/**
+ * @brief Get the zone list a chunk of \a size is served from, with the current
+ * class boundaries. The caller must hold the memory lock.
+ * @param size The aligned size
+ * @return The head of the zone list, NULL above the zones
+ */
+static zone_t *free_sized_head(size_t size) {
+    switch (stats_class(size)) {
+        case STATS_TINY:
+            return &memory_g.tiny_head;
+        case STATS_SMALL:
+            return &memory_g.small_head;
+        case STATS_MEDIUM:
+            return &memory_g.medium_head;
+        default:
+            return NULL;
+    }
+}
+
+#ifdef MALLOC_CACHE
+/**
+ * @brief Cache a chunk being freed without taking the memory lock. Unless the
+ * caller is trusted (MALLOC_HARDENING_FAST), the chunk is checked as
+ * free_release would: its magic, its used flag and the cache mark. Tiny
+ * chunks are never in a quick list, so no other check needs the lock.
+ * Only the main heap is cached.
+ * @param ptr The pointer being freed, not NULL
+ * @return true if the chunk was cached, false if it must be freed under the lock,
+ * which reports it when a check failed
+ */
+static bool free_cache(void *ptr) {
+    const chunk_t chunk = (chunk_t)(ptr - CHUNK_METADATA_SIZE);
+
+    if (&memory_g != &memory_main_g) {
+        return false;
+    }
+#if HARDENING_CHECK
+    if (!chunk_check(chunk) || chunk->free == 1 || cache_contains(chunk)) {
+        return false;
+    }
+#endif
+    return cache_push(chunk);
+}
+#endif
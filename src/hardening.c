@@ -0,0 +1,30 @@
+#include "hardening.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/auxv.h>
+
+static _Atomic uintptr_t hardening_secret_g = 0;
+
+/**
+ * @brief Get the per-process secret used to seal chunk headers and encode
+ * pointers. It comes from the random bytes the kernel gives to every process,
+ * so concurrent first calls all compute the same value.
+ * @return The secret, never 0
+ */
+uintptr_t hardening_secret(void) {
+    uintptr_t secret = atomic_load_explicit(&hardening_secret_g, memory_order_relaxed);
+    const void *random;
+
+    if (secret != 0) {
+        return secret;
+    }
+    secret = (uintptr_t)&hardening_secret_g;
+    random = (const void*)getauxval(AT_RANDOM);
+    if (random != NULL) {
+        memcpy(&secret, random, sizeof(secret));
+    }
+    secret |= 1;
+    atomic_store_explicit(&hardening_secret_g, secret, memory_order_relaxed);
+    return secret;
+}
@@ -0,0 +1,129 @@
+#include "heap.h"
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "chunk.h"
+#include "def.h"
+#include "free.h"
+#include "realloc.h"
+#include "stats.h"
+#include "utils.h"
+
+static void heap_lock(heap_t heap);
+static void heap_unlock(void);
+static void heap_unmap_zones(zone_t zone);
+
+/**
+ * @brief Create an empty private heap
+ * @param config The configuration of the heap, NULL to use the one of the
+ * main heap
+ * @return The heap, NULL if memory couldn't be mapped
+ */
+heap_t heap_create(const config_t *config) {
+    heap_t heap;
+
+    //The mapping is zero filled, so every list, stat and tick starts empty
+    heap = mmap_wrapper(sizeof(struct heap_s));
+    if (heap == NULL) {
+        return NULL;
+    }
+    heap->config = config != NULL ? *config : config_g;
+    config_clamp(&heap->config);
+    heap->memory.config = &heap->config;
+    heap->memory.tiny_max = TINY_CHUNK_SIZE;
+    heap->memory.small_max = SMALL_CHUNK_SIZE;
+    heap->memory.large_threshold = ALIGN_MEM(heap->config.large_threshold_min);
+    if (pthread_mutex_init(&heap->memory.lock, NULL) != 0) {
+        munmap(heap, sizeof(struct heap_s));
+        return NULL;
+    }
+    return heap;
+}
+
+void *heap_malloc(heap_t heap, size_t size) {
+    chunk_t chunk;
+
+    heap_lock(heap);
+    //Private heaps are never reclaimed, the lock is held throughout
+    chunk = chunk_get(ALIGN_MEM(size));
+    if (chunk != NULL) {
+        stats_request(size, chunk);
+    }
+    heap_unlock();
+    if (chunk == NULL) {
+        return NULL;
+    }
+    return chunk->data;
+}
+
+void heap_free(heap_t heap, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    heap_lock(heap);
+    free_ptr(ptr);
+    heap_unlock();
+}
+
+void *heap_realloc(heap_t heap, void *ptr, size_t size) {
+    void *ret;
+
+    if (ptr == NULL) {
+        return heap_malloc(heap, size);
+    }
+    heap_lock(heap);
+    ret = realloc_chunk(ptr, size);
+    heap_unlock();
+    return ret;
+}
+
+/**
+ * @brief Unmap every zone and large chunk of \a heap, then the heap itself.
+ * No chunk is visited, so the cost only depends on the number of mappings.
+ * @param heap The heap to destroy, must not be used by another thread
+ */
+void heap_destroy(heap_t heap) {
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    const registry_t *large = &heap->memory.large;
+    chunk_t chunk;
+
+    heap_unmap_zones(heap->memory.tiny_head);
+    heap_unmap_zones(heap->memory.small_head);
+    heap_unmap_zones(heap->memory.medium_head);
+    for (size_t i = 0; i < large->capacity; i++) {
+        chunk = large->entries[i].chunk;
+        if (chunk != NULL) {
+            munmap((void*)((uintptr_t)chunk & ~(page_size - 1)), large->entries[i].size);
+        }
+    }
+    registry_clear(&heap->memory.large);
+    pthread_mutex_destroy(&heap->memory.lock);
+    munmap(heap, sizeof(struct heap_s));
+}
+
+/**
+ * @brief Lock \a heap and make it the heap of the calling thread, so that
+ * every chunk and zone function works on it
+ */
+static void heap_lock(heap_t heap) {
+    pthread_mutex_lock(&heap->memory.lock);
+    memory_current_g = &heap->memory;
+}
+
+static void heap_unlock(void) {
+    memory_t *memory = memory_current_g;
+
+    memory_current_g = &memory_main_g;
+    pthread_mutex_unlock(&memory->lock);
+}
+
+static void heap_unmap_zones(zone_t zone) {
+    zone_t next;
+
+    while (zone) {
+        next = zone->next;
+        munmap(zone, zone->size + ZONE_METADATA_SIZE);
+        zone = next;
+    }
+}
@@ -0,0 +1,141 @@
+#include "latency.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "utils.h"
+
+static latency_block_t  *latency_block_get(void);
+static void             latency_block_release(void *arg);
+static void             latency_key_init(void);
+static size_t           latency_bucket(uint64_t ticks);
+
+_Atomic bool latency_enabled_g = false;
+__thread latency_path_t latency_path_g __attribute__((tls_model("initial-exec"))) = LATENCY_PATH_FAST;
+
+// Every block ever mapped, blocks of exited threads are kept for their counts
+static latency_block_t * _Atomic    latency_blocks_g = NULL;
+static pthread_key_t                latency_key_g;
+static pthread_once_t               latency_once_g = PTHREAD_ONCE_INIT;
+
+static __thread latency_block_t *latency_block_g __attribute__((tls_model("initial-exec"))) = NULL;
+static __thread bool            latency_busy_g __attribute__((tls_model("initial-exec"))) = false;
+
+/**
+ * @brief Start or stop recording the latency of malloc, free and realloc.
+ * Only has an effect when built with MALLOC_LATENCY.
+ */
+void latency_enable(bool enable) {
+    if (enable) {
+        pthread_once(&latency_once_g, latency_key_init);
+    }
+    atomic_store(&latency_enabled_g, enable);
+}
+
+/**
+ * @brief Count a call of \a op that took \a ticks in the histograms of the
+ * calling thread, in the path it marked
+ */
+void latency_record(latency_op_t op, uint64_t ticks) {
+    latency_block_t *block = latency_block_get();
+    _Atomic uint64_t *bucket;
+
+    if (block == NULL) {
+        return;
+    }
+    //Only this thread writes to its block, readers can see a stale count
+    bucket = &block->buckets[op][latency_path_g][latency_bucket(ticks)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Sum the histograms of every thread
+ * @param buckets Set to the LATENCY_BUCKET_COUNT counts of \a op in \a path
+ */
+void latency_collect(latency_op_t op, latency_path_t path, uint64_t *buckets) {
+    memset(buckets, 0, LATENCY_BUCKET_COUNT * sizeof(*buckets));
+    for (latency_block_t *it = atomic_load(&latency_blocks_g); it; it = it->next) {
+        for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+            buckets[i] += atomic_load_explicit(&it->buckets[op][path][i], memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Get the highest latency counted in \a bucket
+ */
+uint64_t latency_bucket_value(size_t bucket) {
+    size_t shift;
+
+    if (bucket < LATENCY_SUB_COUNT) {
+        return bucket;
+    }
+    shift = bucket / LATENCY_SUB_COUNT - 1;
+    //Wraps to UINT64_MAX for the last bucket
+    return ((uint64_t)(LATENCY_SUB_COUNT + bucket % LATENCY_SUB_COUNT + 1) << shift) - 1;
+}
+
+/**
+ * @brief Get the block of the calling thread, taking one left by an exited
+ * thread or mapping a new one on its first call
+ * @return The block, NULL if none could be mapped
+ */
+static latency_block_t *latency_block_get(void) {
+    latency_block_t *block;
+    bool used;
+
+    if (latency_block_g != NULL) {
+        return latency_block_g;
+    }
+    //pthread_setspecific may allocate, in which case the call isn't counted
+    if (latency_busy_g) {
+        return NULL;
+    }
+    latency_busy_g = true;
+    for (block = atomic_load(&latency_blocks_g); block; block = block->next) {
+        used = false;
+        if (atomic_compare_exchange_strong(&block->used, &used, true)) {
+            break;
+        }
+    }
+    if (block == NULL) {
+        //The mapping is zero filled so every bucket starts empty
+        block = mmap_wrapper(sizeof(latency_block_t));
+        if (block != NULL) {
+            atomic_init(&block->used, true);
+            block->next = atomic_load(&latency_blocks_g);
+            while (!atomic_compare_exchange_weak(&latency_blocks_g, &block->next, block));
+        }
+    }
+    if (block != NULL) {
+        latency_block_g = block;
+        pthread_setspecific(latency_key_g, block);
+    }
+    latency_busy_g = false;
+    return block;
+}
+
+/**
+ * @brief Thread exit destructor, leave the block to the next thread
+ */
+static void latency_block_release(void *arg) {
+    latency_block_t *block = arg;
+
+    latency_block_g = NULL;
+    atomic_store(&block->used, false);
+}
+
+static void latency_key_init(void) {
+    pthread_key_create(&latency_key_g, latency_block_release);
+}
+
+static size_t latency_bucket(uint64_t ticks) {
+    size_t major;
+
+    if (ticks < LATENCY_SUB_COUNT) {
+        return ticks;
+    }
+    major = 63 - __builtin_clzll(ticks);
+    return (major - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT
+        + ((ticks >> (major - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1));
+}
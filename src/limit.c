@@ -0,0 +1,70 @@
+#include "limit.h"
+
+#include <stdatomic.h>
+
+#include "cache.h"
+#include "maintenance.h"
+#include "memory.h"
+#include "quick.h"
+#include "stats.h"
+#include "zone.h"
+
+static _Atomic limit_callback_t limit_callback_g = NULL;
+
+/**
+ * @brief Set the callback run before an allocation fails, NULL to remove it
+ */
+void limit_set_callback(limit_callback_t callback) {
+    atomic_store(&limit_callback_g, callback);
+}
+
+/**
+ * @brief Check that mapping \a size more bytes keeps the heap of the calling
+ * thread under its configured limit. The caller must hold its lock.
+ * @param size The size of the mapping about to be made
+ * @return false if the mapping must not be made
+ */
+bool limit_check(size_t size) {
+    const size_t limit = memory_g.config->limit;
+
+    return limit == 0 || (size <= limit && stats_mapped() <= limit - size);
+}
+
+/**
+ * @brief Check whether the heap of the calling thread is close to its limit,
+ * in which case empty zones and large mappings shouldn't be kept around.
+ * The caller must hold its lock.
+ */
+bool limit_pressure(void) {
+    const size_t limit = memory_g.config->limit;
+
+    return limit != 0 && stats_mapped() > limit - limit / LIMIT_PRESSURE_RATIO;
+}
+
+/**
+ * @brief Give back to the system everything the main heap holds without
+ * using it: the mappings queued for the maintenance thread, the tiny cache
+ * and every empty zone, then run the user callback.
+ * Must be called without holding the memory lock.
+ * @param size The size of the allocation that failed
+ */
+void limit_reclaim(size_t size) {
+    const limit_callback_t callback = atomic_load(&limit_callback_g);
+    zone_t *heads[] = {&memory_g.tiny_head, &memory_g.small_head, &memory_g.medium_head};
+
+    maintenance_run(true);
+#ifdef MALLOC_CACHE
+    cache_flush();
+#endif
+    memory_lock();
+#ifdef MALLOC_QUICK_LIST
+    quick_flush(NULL);
+#endif
+    for (size_t i = 0; i < sizeof(heads) / sizeof(*heads); i++) {
+        zone_trim(heads[i]);
+    }
+    memory_unlock();
+    if (callback != NULL) {
+        callback(size);
+    }
+}
@@ -0,0 +1,434 @@
+#include "maintenance.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "chunk.h"
+#include "config.h"
+#include "def.h"
+#include "limit.h"
+#include "memory.h"
+#include "quick.h"
+#include "stats.h"
+#include "tree.h"
+
+/**
+ * A zone that became empty, kept mapped until it has been unused for
+ * config_g.decay_ms, or a used zone left with a big free chunk, whose pages
+ * are purged once it's been so for as long
+ */
+typedef struct {
+    zone_t      *zone_head;
+    zone_t      zone;
+    uint64_t    since;
+} maintenance_zone_t;
+
+/**
+ * A large mapping that was freed. Until the maintenance thread unmaps it, it
+ * can be reused by a large allocation of the same page count. It's still
+ * counted in the large class stats, so that the limit sees it.
+ */
+typedef struct {
+    void        *map;
+    size_t      size;
+    uint64_t    since;
+} maintenance_map_t;
+
+/**
+ * The queues are only used for the main heap, and are guarded by its lock
+ */
+typedef struct {
+    _Atomic bool        running;
+    _Atomic bool        pregrow;    // A class ran low since the last pass
+    pthread_t           thread;
+    pthread_mutex_t     mutex;      // Only guards the sleep of the thread
+    pthread_cond_t      wake;
+    maintenance_zone_t  zones[MAINTENANCE_QUEUE_SIZE];
+    size_t              zone_count;
+    maintenance_map_t   maps[MAINTENANCE_QUEUE_SIZE];
+    size_t              map_count;
+} maintenance_t;
+
+static void     *maintenance_routine(void *arg);
+static void     maintenance_pregrow(void);
+static bool     maintenance_low(zone_t *zone_head, size_t *zone_size);
+static bool     maintenance_zone(const maintenance_zone_t *entry, maintenance_map_t *unmap);
+static void     maintenance_purge(zone_t zone);
+static uint64_t maintenance_now(void);
+static size_t   maintenance_page_round(size_t size);
+
+static maintenance_t maintenance_g = {
+    .running = false,
+    .pregrow = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * @brief Start the maintenance thread. From then on, empty zones and large
+ * mappings of the main heap are released by the thread once they have been
+ * unused for config_g.decay_ms, instead of being unmapped by free.
+ * @return false if the thread couldn't be created
+ */
+bool maintenance_start(void) {
+    if (atomic_exchange(&maintenance_g.running, true)) {
+        return true;
+    }
+    if (pthread_create(&maintenance_g.thread, NULL, maintenance_routine, NULL) != 0) {
+        atomic_store(&maintenance_g.running, false);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stop the maintenance thread, and release everything it still held
+ */
+void maintenance_stop(void) {
+    if (!atomic_exchange(&maintenance_g.running, false)) {
+        return;
+    }
+    pthread_mutex_lock(&maintenance_g.mutex);
+    pthread_cond_signal(&maintenance_g.wake);
+    pthread_mutex_unlock(&maintenance_g.mutex);
+    pthread_join(maintenance_g.thread, NULL);
+    maintenance_run(true);
+}
+
+/**
+ * @brief Do one maintenance pass: unmap the empty zones and the mappings
+ * unused for config_g.decay_ms. The last empty zone of a class is purged
+ * instead, its pages are given back but it stays mapped, and so are the free
+ * pages of the used zones queued. The munmap calls are made after the memory
+ * lock is released.
+ * @param force Release everything queued, whatever its age. Implied when
+ * the main heap is close to its limit.
+ */
+void maintenance_run(bool force) {
+    maintenance_map_t unmaps[MAINTENANCE_QUEUE_SIZE * 2];
+    size_t unmap_count = 0;
+    const uint64_t now = maintenance_now();
+    size_t i;
+
+    memory_lock();
+#ifdef MALLOC_QUICK_LIST
+    //Coalesce what was freed since the last pass, so empty zones can decay
+    quick_flush(NULL);
+#endif
+    //Close to the limit, nothing is worth keeping
+    force |= limit_pressure();
+    i = 0;
+    while (i < maintenance_g.zone_count) {
+        const maintenance_zone_t *entry = &maintenance_g.zones[i];
+
+        if (!force && now - entry->since < config_g.decay_ms) {
+            i++;
+            continue;
+        }
+        if (maintenance_zone(entry, &unmaps[unmap_count])) {
+            unmap_count++;
+        }
+        maintenance_g.zones[i] = maintenance_g.zones[--maintenance_g.zone_count];
+    }
+    i = 0;
+    while (i < maintenance_g.map_count) {
+        if (!force && now - maintenance_g.maps[i].since < config_g.decay_ms) {
+            i++;
+            continue;
+        }
+        stats_zone_remove(NULL, maintenance_g.maps[i].size);
+        unmaps[unmap_count++] = maintenance_g.maps[i];
+        maintenance_g.maps[i] = maintenance_g.maps[--maintenance_g.map_count];
+    }
+    memory_unlock();
+    for (i = 0; i < unmap_count; i++) {
+        munmap(unmaps[i].map, unmaps[i].size);
+    }
+}
+
+/**
+ * @brief Queue \a zone when free left it empty, instead of calling zone_unmap,
+ * or when it left a free chunk of at least MAINTENANCE_PURGE_PAGES pages in it,
+ * so that its pages are purged. The caller must hold the memory lock.
+ * @param zone_head The head of the zone list containing \a zone
+ * @param zone The zone of the chunk just freed
+ * @return false if zone_unmap must be called, because the thread isn't
+ * running, the heap is private or the queue is full
+ */
+bool maintenance_defer_zone(zone_t *zone_head, zone_t zone) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    const bool empty = zone_empty(zone);
+
+    if (!atomic_load_explicit(&maintenance_g.running, memory_order_relaxed)
+        || &memory_g != &memory_main_g) {
+        return false;
+    }
+    //Only a free emptying a zone can give zone_unmap something to do
+    if (!empty && zone->max_free < MAINTENANCE_PURGE_PAGES * page_size) {
+        return true;
+    }
+    for (size_t i = 0; i < maintenance_g.zone_count; i++) {
+        if (maintenance_g.zones[i].zone == zone) {
+            maintenance_g.zones[i].since = maintenance_now();
+            return true;
+        }
+    }
+    if (maintenance_g.zone_count == MAINTENANCE_QUEUE_SIZE) {
+        return !empty;
+    }
+    maintenance_g.zones[maintenance_g.zone_count++] = (maintenance_zone_t){
+        .zone_head = zone_head,
+        .zone = zone,
+        .since = maintenance_now(),
+    };
+    return true;
+}
+
+/**
+ * @brief Queue the mapping of a freed large chunk instead of unmapping it.
+ * The caller must hold the memory lock, and keep the mapping in the stats.
+ * @param map The start of the mapping
+ * @param size The size of the mapping
+ * @return false if the mapping must be unmapped by the caller
+ */
+bool maintenance_defer_unmap(void *map, size_t size) {
+    if (!atomic_load_explicit(&maintenance_g.running, memory_order_relaxed)
+        || &memory_g != &memory_main_g
+        || maintenance_g.map_count == MAINTENANCE_QUEUE_SIZE) {
+        return false;
+    }
+    maintenance_g.maps[maintenance_g.map_count++] = (maintenance_map_t){
+        .map = map,
+        .size = size,
+        .since = maintenance_now(),
+    };
+    return true;
+}
+
+/**
+ * @brief Take back a queued mapping spanning as many pages as \a size, if
+ * the limit allows mapping it. It's removed from the stats, the caller
+ * accounts it again like a new mapping.
+ * The caller must hold the memory lock.
+ * @param size The size of the mapping needed
+ * @return The mapping, NULL if none was queued or the limit is reached
+ */
+void *maintenance_reuse(size_t size) {
+    maintenance_map_t *entry;
+    void *map;
+
+    if (&memory_g != &memory_main_g) {
+        return NULL;
+    }
+    size = maintenance_page_round(size);
+    for (size_t i = 0; i < maintenance_g.map_count; i++) {
+        entry = &maintenance_g.maps[i];
+        if (maintenance_page_round(entry->size) != size) {
+            continue;
+        }
+        stats_zone_remove(NULL, entry->size);
+        if (!limit_check(entry->size)) {
+            stats_zone_add(NULL, entry->size);
+            return NULL;
+        }
+        map = entry->map;
+        *entry = maintenance_g.maps[--maintenance_g.map_count];
+        return map;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Wake the thread up when the class of \a zone_head is about to run out
+ * of free space, so that it maps the next zone before an allocation has to.
+ * The caller must hold the memory lock.
+ * @param zone_head The head of the zone list an allocation was just made from
+ */
+void maintenance_notify(zone_t *zone_head) {
+    if (!config_g.pregrow || &memory_g != &memory_main_g
+        || !atomic_load_explicit(&maintenance_g.running, memory_order_relaxed)
+        || !maintenance_low(zone_head, NULL)
+        || atomic_exchange_explicit(&maintenance_g.pregrow, true, memory_order_relaxed)) {
+        return;
+    }
+    pthread_cond_signal(&maintenance_g.wake);
+}
+
+/**
+ * @brief Fork handlers, called by those of memory.c with the memory lock held.
+ * The thread isn't forked: the child gets a fresh state, and a new thread
+ * when the parent had one. The queues are kept, the new thread releases them,
+ * or they're released at once if it can't be created.
+ */
+void maintenance_fork_prepare(void) {
+    pthread_mutex_lock(&maintenance_g.mutex);
+}
+
+void maintenance_fork_parent(void) {
+    pthread_mutex_unlock(&maintenance_g.mutex);
+}
+
+void maintenance_fork_child(void) {
+    pthread_mutex_init(&maintenance_g.mutex, NULL);
+    pthread_cond_init(&maintenance_g.wake, NULL);
+    atomic_store(&maintenance_g.pregrow, false);
+    if (atomic_exchange(&maintenance_g.running, false) && !maintenance_start()) {
+        maintenance_run(true);
+    }
+}
+
+static void *maintenance_routine(void *arg) {
+    struct timespec deadline;
+    uint64_t period;
+
+    (void)arg;
+    pthread_mutex_lock(&maintenance_g.mutex);
+    while (atomic_load(&maintenance_g.running)) {
+        period = config_g.decay_ms / 2 < MAINTENANCE_PERIOD_MIN ? MAINTENANCE_PERIOD_MIN : config_g.decay_ms / 2;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += period / 1000 + (deadline.tv_nsec + period % 1000 * 1000000) / 1000000000;
+        deadline.tv_nsec = (deadline.tv_nsec + period % 1000 * 1000000) % 1000000000;
+        pthread_cond_timedwait(&maintenance_g.wake, &maintenance_g.mutex, &deadline);
+        if (!atomic_load(&maintenance_g.running)) {
+            break;
+        }
+        pthread_mutex_unlock(&maintenance_g.mutex);
+        maintenance_run(false);
+        if (config_g.pregrow) {
+            maintenance_pregrow();
+        }
+        pthread_mutex_lock(&maintenance_g.mutex);
+    }
+    pthread_mutex_unlock(&maintenance_g.mutex);
+    return NULL;
+}
+
+/**
+ * @brief Map a zone ahead of time for every class running low on free space.
+ * The mmap, and the prefault, are made without holding the memory lock.
+ */
+static void maintenance_pregrow(void) {
+    zone_t *heads[] = {&memory_g.tiny_head, &memory_g.small_head, &memory_g.medium_head};
+    size_t zone_size;
+    zone_t zone;
+
+    atomic_store_explicit(&maintenance_g.pregrow, false, memory_order_relaxed);
+    for (size_t i = 0; i < sizeof(heads) / sizeof(*heads); i++) {
+        memory_lock();
+        if (!maintenance_low(heads[i], &zone_size) || limit_pressure() || !limit_check(zone_size)) {
+            memory_unlock();
+            continue;
+        }
+        memory_unlock();
+        zone = zone_map(zone_size);
+        if (zone == NULL) {
+            continue;
+        }
+        memory_lock();
+        zone->next = *heads[i];
+        *heads[i] = zone;
+        stats_zone_add(heads[i], zone->size + ZONE_METADATA_SIZE);
+        chunk_tree_insert(heads[i], zone, zone_get_chunk(zone));
+        memory_unlock();
+    }
+}
+
+/**
+ * @brief Check whether the class of \a zone_head is in use and has less than
+ * a zone / MAINTENANCE_PREGROW_RATIO free. The caller must hold the memory lock.
+ * @param zone_size Set to the size of the mapping of a new zone of the class
+ * if not NULL
+ */
+static bool maintenance_low(zone_t *zone_head, size_t *zone_size) {
+    const stats_t *stats = stats_of(zone_head);
+    size_t size;
+
+    if (zone_head == &memory_g.tiny_head) {
+        size = zone_growth_size(zone_head, memory_g.tiny_max);
+    } else if (zone_head == &memory_g.small_head) {
+        size = zone_growth_size(zone_head, memory_g.small_max);
+    } else {
+        size = zone_growth_size(zone_head, memory_g.small_max + ALIGN_SIZE);
+    }
+    if (zone_size != NULL) {
+        *zone_size = size;
+    }
+    return size != 0 && stats->zone_count > 0 && stats->free_size < size / MAINTENANCE_PREGROW_RATIO;
+}
+
+/**
+ * @brief Release a queued zone: unlink it to be unmapped if its class has
+ * another empty zone, purge its pages otherwise. A zone used since it was
+ * queued only has the pages of its free chunks purged. Zones already
+ * unmapped since they were queued are left alone.
+ * The caller must hold the memory lock.
+ * @param unmap Set to the mapping to unmap once the lock is released
+ * @return true if \a unmap was set
+ */
+static bool maintenance_zone(const maintenance_zone_t *entry, maintenance_map_t *unmap) {
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    const zone_t zone = entry->zone;
+    size_t empty_count = 0;
+    bool listed = false;
+
+    for (zone_t it = *entry->zone_head; it; it = it->next) {
+        listed |= it == zone;
+        empty_count += zone_empty(it);
+    }
+    //Reserved zones keep their pages too, they were faulted in on purpose
+    if (!listed || zone_reserved(entry->zone_head, zone)) {
+        return false;
+    }
+    if (!zone_empty(zone)) {
+        maintenance_purge(zone);
+        return false;
+    }
+    if (empty_count > 1) {
+        zone_remove(entry->zone_head, zone);
+        unmap->map = zone;
+        unmap->size = zone->size + ZONE_METADATA_SIZE;
+        return true;
+    }
+    //The first page holds the zone and chunk headers
+    madvise((void*)((uintptr_t)zone + page_size), zone->size + ZONE_METADATA_SIZE - page_size, MADV_DONTNEED);
+    return false;
+}
+
+/**
+ * @brief Give back the pages inside the free chunks of a used zone. The page
+ * holding the header of a chunk, and the tree node after it, is kept.
+ * The caller must hold the memory lock.
+ */
+static void maintenance_purge(zone_t zone) {
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t start;
+    uintptr_t end;
+
+    for (chunk_t chunk = zone_get_chunk(zone); chunk; chunk = chunk->next) {
+        if (!chunk->free) {
+            continue;
+        }
+        start = ((uintptr_t)chunk->data + TREE_MIN_SIZE + page_size - 1) & ~(page_size - 1);
+        end = ((uintptr_t)chunk->data + chunk->size) & ~(page_size - 1);
+        if (end > start) {
+            madvise((void*)start, end - start, MADV_DONTNEED);
+        }
+    }
+}
+
+static uint64_t maintenance_now(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static size_t maintenance_page_round(size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    return (size + page_size - 1) & ~(page_size - 1);
+}
@@ -2,16 +2,106 @@
 
 #include <unistd.h>
 
+#include "cache.h"
 #include "chunk.h"
 #include "def.h"
+#include "latency.h"
+#include "memory.h"
+#include "stats.h"
+
+static void *malloc_size(size_t size);
+static void *malloc_zone(size_t requested, zone_t *zone_head, zone_t *zone_rover);
+static bool malloc_in_class(size_t size, const zone_t *zone_head);
 
 void *malloc(size_t size) {
+    const uint64_t start = latency_start();
+    void *ptr = malloc_size(size);
+
+    latency_end(LATENCY_MALLOC, start);
+    return ptr;
+}
+
+/**
+ * @brief Entry point of the tiny class, for callers that resolved the class
+ * at compile time (see malloc_inline.h). The class boundaries move at
+ * runtime, a size out of the tiny class is served as malloc would
+ * @param size The size to allocate, expected to align to at most TINY_CHUNK_SIZE
+ * @return The allocated memory, NULL on failure
+ */
+void *malloc_tiny(size_t size) {
+#ifdef MALLOC_CACHE
+    const chunk_t chunk = cache_pop(ALIGN_MEM(size));
+
+    if (chunk != NULL) {
+        return chunk->data;
+    }
+#endif
+    return malloc_zone(size, &memory_g.tiny_head, &memory_g.tiny_rover);
+}
+
+/**
+ * @brief Entry point of the small class, see malloc_tiny
+ * @param size The size to allocate, expected to align to more than
+ * TINY_CHUNK_SIZE and at most SMALL_CHUNK_SIZE
+ * @return The allocated memory, NULL on failure
+ */
+void *malloc_small(size_t size) {
+    return malloc_zone(size, &memory_g.small_head, &memory_g.small_rover);
+}
+
+static void *malloc_size(size_t size) {
+    const size_t requested = size;
     chunk_t chunk;
 
     size = ALIGN_MEM(size);
+#ifdef MALLOC_CACHE
+    chunk = cache_pop(size);
+    if (chunk != NULL) {
+        return chunk->data;
+    }
+#endif
+    memory_lock();
+    //May release the lock to reclaim memory, nothing is looked up before it
     chunk = chunk_get(size);
+    if (chunk != NULL) {
+        stats_request(requested, chunk);
+    }
+    memory_unlock();
+    if (chunk == NULL) {
+        return NULL;
+    }
+    return chunk->data;
+}
+
+static void *malloc_zone(size_t requested, zone_t *zone_head, zone_t *zone_rover) {
+    const size_t size = ALIGN_MEM(requested);
+    chunk_t chunk;
+
+    memory_lock();
+    //Like malloc_size, nothing is kept across the reclaim chunk_get_zone may do
+    if (malloc_in_class(size, zone_head)) {
+        chunk = chunk_get_zone(zone_head, zone_rover, size);
+    } else {
+        chunk = chunk_get(size);
+    }
+    if (chunk != NULL) {
+        stats_request(requested, chunk);
+    }
+    memory_unlock();
     if (chunk == NULL) {
         return NULL;
     }
     return chunk->data;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Check \a size against the runtime boundaries of the class of
+ * \a zone_head, which class_tune may have moved since the caller resolved it.
+ * Must be called with the lock held
+ */
+static bool malloc_in_class(size_t size, const zone_t *zone_head) {
+    if (zone_head == &memory_g.tiny_head) {
+        return size <= memory_g.tiny_max;
+    }
+    return size > memory_g.tiny_max && size <= memory_g.small_max;
+}
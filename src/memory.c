@@ -1,7 +1,68 @@
 #include "memory.h"
 
-memory_t memory_g = {
+#include "chunk.h"
+#include "config.h"
+#include "maintenance.h"
+
+static void memory_fork_prepare(void);
+static void memory_fork_parent(void);
+static void memory_fork_child(void);
+
+memory_t memory_main_g = {
     .tiny_head = NULL,
     .small_head = NULL,
-    .large_head = NULL,
-};
\ No newline at end of file
+    .medium_head = NULL,
+    .tiny_rover = NULL,
+    .small_rover = NULL,
+    .medium_rover = NULL,
+    .large = {
+        .entries = NULL,
+        .capacity = 0,
+        .count = 0,
+    },
+    .small_tree = NULL,
+    .tiny_max = TINY_CHUNK_SIZE,
+    .small_max = SMALL_CHUNK_SIZE,
+    .large_threshold = CONFIG_LARGE_THRESHOLD_MIN,
+    .tick = 0,
+    .config = &config_g,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+__thread memory_t *memory_current_g __attribute__((tls_model("initial-exec"))) = &memory_main_g;
+
+/**
+ * @brief Lock the main heap, every access to it outside the cache fast
+ * path must be done while holding this lock
+ */
+void memory_lock(void) {
+    pthread_mutex_lock(&memory_main_g.lock);
+}
+
+void memory_unlock(void) {
+    pthread_mutex_unlock(&memory_main_g.lock);
+}
+
+/**
+ * @brief Register the fork handlers. The main heap is locked across fork, so
+ * a child never inherits it locked by a thread that doesn't exist there.
+ * Called once, by config_init.
+ */
+void memory_atfork(void) {
+    pthread_atfork(memory_fork_prepare, memory_fork_parent, memory_fork_child);
+}
+
+static void memory_fork_prepare(void) {
+    memory_lock();
+    maintenance_fork_prepare();
+}
+
+static void memory_fork_parent(void) {
+    maintenance_fork_parent();
+    memory_unlock();
+}
+
+static void memory_fork_child(void) {
+    pthread_mutex_init(&memory_main_g.lock, NULL);
+    maintenance_fork_child();
+}
@@ -0,0 +1,139 @@
+#include <cstddef>
+#include <new>
+
+/*
+ * The C headers of the allocator declare the C library functions without
+ * noexcept, which conflicts with <cstdlib>, so the entry points are declared
+ * here instead.
+ */
+extern "C" {
+    void *malloc(std::size_t size) noexcept;
+    void *aligned_alloc(std::size_t alignment, std::size_t size) noexcept;
+    void free(void *ptr) noexcept;
+    void free_sized(void *ptr, std::size_t size) noexcept;
+}
+
+namespace {
+
+/**
+ * @brief Allocate through \a alloc, calling the new handler until it succeeds
+ * @throw std::bad_alloc if there is no new handler
+ */
+template <typename Alloc>
+void *new_get(Alloc alloc) {
+    void *ptr;
+
+    while ((ptr = alloc()) == nullptr) {
+        const std::new_handler handler = std::get_new_handler();
+
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    return ptr;
+}
+
+void *new_size(std::size_t size) {
+    //operator new must return a distinct pointer for a zero size
+    return new_get([size] { return malloc(size ? size : 1); });
+}
+
+void *new_aligned(std::size_t size, std::align_val_t alignment) {
+    return new_get([size, alignment] {
+        return aligned_alloc(static_cast<std::size_t>(alignment), size ? size : 1);
+    });
+}
+
+template <typename New>
+void *new_nothrow(New allocate) noexcept {
+    try {
+        return allocate();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+}
+
+void *operator new(std::size_t size) {
+    return new_size(size);
+}
+
+void *operator new[](std::size_t size) {
+    return new_size(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return new_nothrow([size] { return new_size(size); });
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return new_nothrow([size] { return new_size(size); });
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return new_aligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return new_aligned(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return new_nothrow([size, alignment] { return new_aligned(size, alignment); });
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return new_nothrow([size, alignment] { return new_aligned(size, alignment); });
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+// The size tells the class of the chunk, so only its zones are searched
+void operator delete(void *ptr, std::size_t size) noexcept {
+    free_sized(ptr, size);
+}
+
+void operator delete[](void *ptr, std::size_t size) noexcept {
+    free_sized(ptr, size);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+// Aligned chunks are cut out of a bigger class, the size can't tell it
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
@@ -0,0 +1,198 @@
+#include "profile.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chunk.h"
+#include "config.h"
+#include "def.h"
+#include "limit.h"
+#include "memory.h"
+#include "utils.h"
+#include "zone.h"
+
+static void     profile_exit(void);
+static zone_t   *profile_head(stats_class_t class);
+static size_t   profile_chunk_size(stats_class_t class);
+
+static const char *profile_names_g[STATS_CLASS_COUNT] = {"tiny", "small", "medium", "large"};
+
+/**
+ * @brief Prewarm the main heap from the profile file of config_g when it
+ * exists, and write the profile of this run to it at exit. Called once the
+ * configuration is loaded.
+ */
+void profile_init(void) {
+    profile_t profile;
+
+    if (config_g.profile == NULL) {
+        return;
+    }
+    if (profile_load(config_g.profile, &profile)) {
+        profile_prewarm(&profile);
+    }
+    atexit(profile_exit);
+}
+
+/**
+ * @brief Write the peak zone count and the bytes each zone class of the heap
+ * of the calling thread needed: its peak of used bytes and the metadata of its
+ * zones, at most its peak mapped bytes. Zones prewarmed but never used are
+ * left out, so the profile shrinks along with the workload. The file is
+ * replaced at once, a reader never sees it half written.
+ * @param path The file to write
+ * @return 0 on success, -1 on failure
+ */
+int profile_save(const char *path) {
+    char tmp_path[PATH_MAX];
+    char buf[PROFILE_BUFFER_SIZE];
+    stats_t stats[STATS_CLASS_COUNT];
+    size_t needed;
+    size_t len;
+    ssize_t written;
+    int fd;
+
+    if ((size_t)snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= sizeof(tmp_path)) {
+        return -1;
+    }
+    memory_lock();
+    memcpy(stats, memory_g.stats, sizeof(stats));
+    memory_unlock();
+    len = snprintf(buf, sizeof(buf), "# class zone_count mapped, written by profile_save\n");
+    for (stats_class_t class = STATS_TINY; class < STATS_LARGE; class++) {
+        needed = stats[class].peak_used + stats[class].peak_zone_count * ZONE_METADATA_SIZE;
+        needed = needed < stats[class].peak_mapped ? needed : stats[class].peak_mapped;
+        len += snprintf(buf + len, sizeof(buf) - len, "%s %zu %zu\n", profile_names_g[class],
+                        stats[class].peak_used ? stats[class].peak_zone_count : 0,
+                        stats[class].peak_used ? needed : 0);
+    }
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    written = write(fd, buf, len);
+    if (close(fd) == -1 || written != (ssize_t)len || rename(tmp_path, path) == -1) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read a file written by profile_save. Unknown lines are skipped.
+ * @param profile Set to the classes found, the others are zeroed
+ * @return false if the file can't be read or holds no class
+ */
+bool profile_load(const char *path, profile_t *profile) {
+    char buf[PROFILE_BUFFER_SIZE];
+    char name[PROFILE_BUFFER_SIZE];
+    char *line;
+    char *save;
+    size_t zone_count;
+    size_t mapped;
+    bool found = false;
+    ssize_t len;
+    int fd;
+
+    memset(profile, 0, sizeof(*profile));
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) {
+        return false;
+    }
+    buf[len] = '\0';
+    for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        if (line[0] == '#' || sscanf(line, "%1023s %zu %zu", name, &zone_count, &mapped) != 3
+            || zone_count > PROFILE_MAX_ZONES) {
+            continue;
+        }
+        for (stats_class_t class = STATS_TINY; class < STATS_LARGE; class++) {
+            if (strcmp(name, profile_names_g[class]) == 0) {
+                profile->zone_count[class] = zone_count;
+                profile->mapped[class] = mapped;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Map and fault in the zones of \a profile in the heap of the calling
+ * thread, its peak bytes split in as many zones as it had. Zones the classes
+ * already have count towards the peak. The peak is then reserved: empty zones
+ * are kept up to it until the class uses as much, see zone_reserved.
+ * @return The bytes mapped
+ */
+size_t profile_prewarm(const profile_t *profile) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t prewarmed = 0;
+    size_t zone_size;
+    size_t min_size;
+    zone_t *zone_head;
+    zone_t zone;
+    bool room;
+
+    for (stats_class_t class = STATS_TINY; class < STATS_LARGE; class++) {
+        if (profile->zone_count[class] == 0) {
+            continue;
+        }
+        zone_head = profile_head(class);
+        memory_lock();
+        memory_g.reserved[class] = profile->mapped[class];
+        zone_size = profile->mapped[class] / profile->zone_count[class];
+        zone_size -= zone_size % page_size;
+        min_size = zone_mapping_size(profile_chunk_size(class));
+        zone_size = zone_size < min_size ? min_size : zone_size;
+        memory_unlock();
+        for (size_t i = 0; i < profile->zone_count[class]; i++) {
+            memory_lock();
+            room = memory_g.stats[class].mapped + zone_size <= profile->mapped[class] && limit_check(zone_size);
+            memory_unlock();
+            if (!room || (zone = zone_map(zone_size)) == NULL) {
+                break;
+            }
+            //zone_map already faulted it in when the configuration asks for it
+            if (!memory_g.config->prefault) {
+                mmap_prefault(zone, zone_size);
+            }
+            memory_lock();
+            zone->next = *zone_head;
+            *zone_head = zone;
+            stats_zone_add(zone_head, zone_size);
+            chunk_tree_insert(zone_head, zone, zone_get_chunk(zone));
+            memory_unlock();
+            prewarmed += zone_size;
+        }
+    }
+    return prewarmed;
+}
+
+static void profile_exit(void) {
+    profile_save(config_g.profile);
+}
+
+static zone_t *profile_head(stats_class_t class) {
+    if (class == STATS_TINY) {
+        return &memory_g.tiny_head;
+    }
+    return class == STATS_SMALL ? &memory_g.small_head : &memory_g.medium_head;
+}
+
+/**
+ * @brief Get the biggest chunk size of a zone class, which sets its smallest zone
+ */
+static size_t profile_chunk_size(stats_class_t class) {
+    if (class == STATS_TINY) {
+        return memory_g.tiny_max;
+    }
+    return class == STATS_SMALL ? memory_g.small_max : memory_g.small_max + ALIGN_SIZE;
+}
@@ -0,0 +1,121 @@
+#include "quick.h"
+
+#include "free.h"
+#include "memory.h"
+
+static void     quick_release(size_t index);
+static zone_t   *quick_head(size_t size);
+
+/**
+ * @brief Keep a chunk being freed in the quick list of its size, without
+ * coalescing it. The caller must hold the memory lock.
+ * @param chunk The validated chunk being freed
+ * @param zone The zone containing \a chunk
+ * @param zone_head The head of the zone list containing \a zone
+ * @return false if the chunk must be freed normally: it's large, above
+ * SMALL_CHUNK_SIZE, too small to hold the link, served by the cache, or it
+ * lives in the zones of another class than the one its size maps to now
+ */
+bool quick_push(chunk_t chunk, zone_t zone, zone_t *zone_head) {
+    quick_t *quick = &memory_g.quick;
+    size_t index;
+
+    if (zone == NULL || chunk->size < QUICK_MIN_SIZE || chunk->size > SMALL_CHUNK_SIZE
+        || quick_head(chunk->size) != zone_head) {
+        return false;
+    }
+#ifdef MALLOC_CACHE
+    //free checks the sizes of the cache without the lock, so without the lists
+    if (chunk->size <= TINY_CHUNK_SIZE) {
+        return false;
+    }
+#endif
+    index = QUICK_INDEX(chunk->size);
+    QUICK_SET_NEXT(chunk, quick->heads[index]);
+    QUICK_SET_ZONE(chunk, zone);
+    quick->heads[index] = chunk;
+    //A churning size stays in its list, a growing one is coalesced in a batch
+    if (++quick->counts[index] > QUICK_LIST_MAX) {
+        quick_release(index);
+    }
+    return true;
+}
+
+/**
+ * @brief Take a chunk of exactly \a size bytes from the quick lists.
+ * The caller must hold the memory lock.
+ * @param size The aligned size
+ * @return A used chunk, NULL if the list of \a size is empty
+ */
+chunk_t quick_pop(size_t size) {
+    quick_t *quick = &memory_g.quick;
+    chunk_t chunk;
+    size_t index;
+
+    if (size < QUICK_MIN_SIZE || size > SMALL_CHUNK_SIZE) {
+        return NULL;
+    }
+    index = QUICK_INDEX(size);
+    chunk = quick->heads[index];
+    if (chunk != NULL) {
+        quick->heads[index] = QUICK_NEXT(chunk);
+        quick->counts[index]--;
+    }
+    return chunk;
+}
+
+/**
+ * @brief Check whether \a chunk is already in a quick list, to detect a
+ * double free. Walks at most QUICK_LIST_MAX chunks.
+ * The caller must hold the memory lock.
+ */
+bool quick_contains(chunk_t chunk) {
+    if (chunk->size < QUICK_MIN_SIZE || chunk->size > SMALL_CHUNK_SIZE) {
+        return false;
+    }
+    for (chunk_t it = memory_g.quick.heads[QUICK_INDEX(chunk->size)]; it; it = QUICK_NEXT(it)) {
+        if (it == chunk) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Coalesce the chunks of the quick lists of a class back into their
+ * zones. The caller must hold the memory lock.
+ * @param zone_head The head of the zone list of the class, NULL for every class
+ * @return false if there was nothing to coalesce
+ */
+bool quick_flush(zone_t *zone_head) {
+    bool flushed = false;
+
+    for (size_t i = 0; i < QUICK_LIST_COUNT; i++) {
+        if (memory_g.quick.heads[i] != NULL
+            && (zone_head == NULL || quick_head((i + 1) * ALIGN_SIZE) == zone_head)) {
+            quick_release(i);
+            flushed = true;
+        }
+    }
+    return flushed;
+}
+
+static void quick_release(size_t index) {
+    quick_t *quick = &memory_g.quick;
+    chunk_t chunk = quick->heads[index];
+    chunk_t next;
+
+    quick->heads[index] = NULL;
+    quick->counts[index] = 0;
+    for (; chunk; chunk = next) {
+        next = QUICK_NEXT(chunk);
+        free_chunk(chunk, QUICK_ZONE(chunk), quick_head(chunk->size));
+    }
+}
+
+static zone_t *quick_head(size_t size) {
+    if (size <= memory_g.tiny_max) {
+        return &memory_g.tiny_head;
+    }
+    return size <= memory_g.small_max ? &memory_g.small_head : &memory_g.medium_head;
+}
@@ -7,44 +7,107 @@
 #include "chunk.h"
 #include "zone.h"
 #include "def.h"
+#include "memory.h"
+#include "hardening.h"
+#include "latency.h"
+#include "stats.h"
 
 #define ERROR_INVALID_PTR_MSG "realloc(): invalid pointer\n"
 #define ERROR_INVALID_PTR_LEN 27
 
 void *realloc(void *ptr, size_t size) {
-    chunk_t chunk;
-    chunk_t new_chunk;
-    zone_t  zone;
+    uint64_t start;
+    void *ret;
 
-    size = ALIGN_MEM(size);
     if (ptr == NULL) {
         return malloc(size);
     }
-    chunk = chunk_validate(ptr, &zone, NULL);
+    start = latency_start();
+    memory_lock();
+    ret = realloc_chunk(ptr, size);
+    memory_unlock();
+    latency_end(LATENCY_REALLOC, start);
+    return ret;
+}
+
+/**
+ * @brief Resize the chunk of \a ptr in place when possible, move it otherwise.
+ * The caller must hold the lock of the heap of the calling thread, see memory_g.
+ * @param ptr The pointer to resize
+ * @param requested The size asked by the caller, before alignment
+ * @return The resized pointer, NULL on failure
+ */
+void *realloc_chunk(void *ptr, size_t requested) {
+    size_t  size = ALIGN_MEM(requested);
+    chunk_t chunk;
+    chunk_t new_chunk;
+    chunk_t remaining;
+    zone_t  zone;
+    zone_t  *zone_head;
+    size_t  old_size;
+
+    chunk = chunk_validate(ptr, &zone, &zone_head);
     if (chunk == NULL) {
+#if HARDENING_CHECK
         write(STDERR_FILENO, ERROR_INVALID_PTR_MSG, ERROR_INVALID_PTR_LEN);
+#endif
         return NULL;
     }
 
+    if (zone_head == &memory_g.medium_head) {
+        //Medium chunks are kept page-granular
+        size = chunk_round_size(size);
+    }
+    old_size = chunk->size;
+    //Large chunks are resized in place, unless the zones serve the new size:
+    //moving copies at most the zone/mmap threshold and gives back the pages
+    if (zone == NULL && size > memory_g.large_threshold && chunk_resize_large(chunk, size)) {
+        stats_request(requested, chunk);
+        return ptr;
+    }
     if (zone && chunk->size >= size) {
         //Here the chunk is large enough to contain the requested size
         //so we simply try to split it
-        chunk_split(chunk, size);
+        remaining = chunk_split(chunk, size);
+        if (remaining != NULL) {
+            chunk_tree_insert(zone_head, zone, remaining);
+            zone->free_size += old_size - chunk->size;
+            if (remaining->size > zone->max_free) {
+                zone->max_free = remaining->size;
+            }
+            stats_used_remove(zone_head, old_size);
+            stats_used_add(zone_head, chunk->size);
+        }
+        stats_request(requested, chunk);
         return ptr;
     }
-    if (zone && chunk->next && chunk->next->free
+    if (zone && chunk_fusable(chunk->next)
         && (chunk->size + CHUNK_METADATA_SIZE + chunk->next->size) >= size) {
         //There is enough space in the next chunk
         //We decide that it's ok to create a chunk of bigger size than usual
         //since it saves an allocation
+        chunk_tree_remove(zone_head, chunk->next);
         chunk_fusion_next(chunk);
-        chunk_split(chunk, size);
+        remaining = chunk_split(chunk, size);
+        if (remaining != NULL) {
+            chunk_tree_insert(zone_head, zone, remaining);
+        }
+        zone->free_size -= chunk->size - old_size;
+        stats_used_remove(zone_head, old_size);
+        stats_used_add(zone_head, chunk->size);
+        stats_request(requested, chunk);
     } else {
-        //We need to allocate a new block
+        //We need to allocate a new block. chunk_get may release the lock to
+        //reclaim memory: chunk is still used, so it and its zone stay valid
         new_chunk = chunk_get(size);
+        if (new_chunk == NULL) {
+            return NULL;
+        }
+        stats_request(requested, new_chunk);
         chunk_copy(chunk, new_chunk);
-        free(ptr);
+        free_chunk(chunk, zone, zone_head);
         return new_chunk->data;
     }
     return ptr;
 }
+
@@ -0,0 +1,145 @@
+#include "region.h"
+
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "chunk.h"
+#include "def.h"
+#include "limit.h"
+#include "memory.h"
+#include "stats.h"
+#include "utils.h"
+
+#define REGION_METADATA_SIZE ALIGN_MEM(sizeof(struct region_s))
+
+static bool     region_grow(region_t region, size_t size);
+static zone_t   region_zone_new(size_t size);
+
+/**
+ * @brief Create an empty region, mapping its first zone
+ * @return The region, NULL if memory couldn't be mapped
+ */
+region_t region_create(void) {
+    region_t region;
+    zone_t zone;
+
+    zone = region_zone_new(REGION_METADATA_SIZE);
+    if (zone == NULL) {
+        return NULL;
+    }
+    region = (region_t)zone->data;
+    region->head = zone;
+    region_reset(region);
+    return region;
+}
+
+/**
+ * @brief Allocate \a size bytes from \a region. There is no header, the
+ * memory is only given back by region_reset or region_destroy.
+ * @param region The region to allocate from
+ * @param size The size to allocate
+ * @return The allocated memory, NULL on failure
+ */
+void *region_alloc(region_t region, size_t size) {
+    void *ptr;
+
+    size = ALIGN_MEM(size);
+    if (size > (size_t)(region->end - region->top) && !region_grow(region, size)) {
+        return NULL;
+    }
+    ptr = region->top;
+    region->top += size;
+    return ptr;
+}
+
+/**
+ * @brief Free every allocation of \a region at once. The zones stay mapped
+ * and are bumped through again by the next allocations.
+ * @param region The region to reset
+ */
+void region_reset(region_t region) {
+    region->current = region->head;
+    region->top = region->head->data + REGION_METADATA_SIZE;
+    region->end = region->head->data + region->head->size;
+}
+
+/**
+ * @brief Unmap every zone of \a region, the region itself included
+ * @param region The region to destroy
+ */
+void region_destroy(region_t region) {
+    zone_t zone = region->head;
+    zone_t next;
+
+    while (zone) {
+        next = zone->next;
+        memory_lock();
+        stats_zone_remove(NULL, zone->size + ZONE_METADATA_SIZE);
+        memory_unlock();
+        munmap(zone, zone->size + ZONE_METADATA_SIZE);
+        zone = next;
+    }
+}
+
+/**
+ * @brief Move to the zone following the current one, mapping a new one when
+ * there is none or when it's too small for \a size
+ * @param region The region to grow
+ * @param size The aligned size that must fit in the new current zone
+ * @return false if memory couldn't be mapped
+ */
+static bool region_grow(region_t region, size_t size) {
+    zone_t zone = region->current->next;
+
+    //Zones kept by a reset are reused in order
+    if (zone == NULL || zone->size < size) {
+        zone = region_zone_new(size);
+        if (zone == NULL) {
+            return false;
+        }
+        zone->next = region->current->next;
+        region->current->next = zone;
+    }
+    region->current = zone;
+    region->top = zone->data;
+    region->end = zone->data + zone->size;
+    return true;
+}
+
+/**
+ * @brief Map a zone with room for at least \a size bytes. Up to the medium
+ * class the zone is sized like the zones of malloc, above it fits \a size.
+ * Either way the mapping is checked against the limit, and counted as a
+ * mapping of the large class since it's in no zone list.
+ * @param size The aligned size that must fit in the zone
+ * @return The zone, NULL if memory couldn't be mapped or the limit refused it
+ */
+static zone_t region_zone_new(size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t zone_size;
+    zone_t zone = NULL;
+
+    size = size < SMALL_CHUNK_SIZE ? SMALL_CHUNK_SIZE : size;
+    if (size > SIZE_MAX - ZONE_METADATA_SIZE - page_size) {
+        return NULL;
+    }
+    memory_lock();
+    zone_size = zone_mapping_size(size);
+    if (zone_size != 0) {
+        zone = zone_new(NULL, size);
+    } else {
+        zone_size = size + ZONE_METADATA_SIZE + page_size - 1;
+        zone_size -= zone_size % page_size;
+        zone = limit_check(zone_size) ? mmap_wrapper(zone_size) : NULL;
+        if (zone != NULL) {
+            zone->next = NULL;
+            zone->size = zone_size - ZONE_METADATA_SIZE;
+        }
+    }
+    if (zone != NULL) {
+        stats_zone_add(NULL, zone_size);
+    }
+    memory_unlock();
+    return zone;
+}
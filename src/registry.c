@@ -0,0 +1,133 @@
+#include "registry.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "utils.h"
+
+#define REGISTRY_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+static bool     registry_grow(registry_t *registry);
+static size_t   registry_hash(const registry_t *registry, chunk_t chunk);
+
+/**
+ * @brief Add a large mapping to the registry, growing it when it's half full
+ * @param registry The registry
+ * @param chunk The mapping to add, must not be registered already
+ * @return The entry of \a chunk, NULL if the registry couldn't grow
+ */
+registry_entry_t *registry_insert(registry_t *registry, chunk_t chunk) {
+    size_t i;
+
+    if ((registry->count + 1) * 2 > registry->capacity && !registry_grow(registry)) {
+        return NULL;
+    }
+    i = registry_hash(registry, chunk);
+    while (registry->entries[i].chunk != NULL) {
+        i = (i + 1) & (registry->capacity - 1);
+    }
+    registry->entries[i].chunk = chunk;
+    registry->entries[i].size = 0;
+    registry->entries[i].birth = 0;
+    registry->count++;
+    return &registry->entries[i];
+}
+
+/**
+ * @brief Find the entry of a large mapping in O(1)
+ * @param registry The registry
+ * @param chunk The mapping searched
+ * @return The entry of \a chunk, NULL if \a chunk isn't a large mapping
+ */
+registry_entry_t *registry_search(registry_t *registry, chunk_t chunk) {
+    size_t i;
+
+    if (registry->count == 0 || chunk == NULL) {
+        return NULL;
+    }
+    i = registry_hash(registry, chunk);
+    while (registry->entries[i].chunk != NULL) {
+        if (registry->entries[i].chunk == chunk) {
+            return &registry->entries[i];
+        }
+        i = (i + 1) & (registry->capacity - 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Remove an entry. The following entries of the probe sequence are
+ * shifted back so that no tombstone is needed.
+ * @param registry The registry
+ * @param entry The entry to remove, as returned by registry_search
+ */
+void registry_remove(registry_t *registry, registry_entry_t *entry) {
+    const size_t mask = registry->capacity - 1;
+    size_t hole = entry - registry->entries;
+    size_t i = hole;
+    size_t home;
+
+    while (1) {
+        i = (i + 1) & mask;
+        if (registry->entries[i].chunk == NULL) {
+            break;
+        }
+        home = registry_hash(registry, registry->entries[i].chunk);
+        //The entry can fill the hole if its home isn't between the hole and it
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            registry->entries[hole] = registry->entries[i];
+            hole = i;
+        }
+    }
+    registry->entries[hole].chunk = NULL;
+    registry->count--;
+}
+
+/**
+ * @brief Release the table of the registry, the mappings aren't touched
+ * @param registry The registry
+ */
+void registry_clear(registry_t *registry) {
+    if (registry->entries != NULL) {
+        munmap(registry->entries, registry->capacity * sizeof(registry_entry_t));
+    }
+    registry->entries = NULL;
+    registry->capacity = 0;
+    registry->count = 0;
+}
+
+static bool registry_grow(registry_t *registry) {
+    const registry_t old = *registry;
+    size_t capacity;
+    registry_entry_t *entries;
+    size_t i;
+
+    capacity = old.capacity ? old.capacity * 2 : REGISTRY_MIN_CAPACITY;
+    entries = mmap_wrapper(capacity * sizeof(registry_entry_t));
+    if (entries == NULL) {
+        return false;
+    }
+    registry->entries = entries;
+    registry->capacity = capacity;
+    for (size_t j = 0; j < old.capacity; j++) {
+        if (old.entries[j].chunk == NULL) {
+            continue;
+        }
+        i = registry_hash(registry, old.entries[j].chunk);
+        while (entries[i].chunk != NULL) {
+            i = (i + 1) & (capacity - 1);
+        }
+        entries[i] = old.entries[j];
+    }
+    if (old.entries != NULL) {
+        munmap(old.entries, old.capacity * sizeof(registry_entry_t));
+    }
+    return true;
+}
+
+static size_t registry_hash(const registry_t *registry, chunk_t chunk) {
+    //Large chunks start in the first page of their mapping, so the low bits carry little information
+    uint64_t hash = ((uintptr_t)chunk >> 12) * REGISTRY_HASH_MULTIPLIER;
+
+    return (hash ^ (hash >> 32)) & (registry->capacity - 1);
+}
@@ -0,0 +1,278 @@
+#include "stats.h"
+
+#include <stdint.h>
+
+#include "class.h"
+#include "def.h"
+#include "memory.h"
+
+static zone_t   stats_zone_head(stats_class_t class);
+static size_t   stats_bucket(size_t size);
+#ifdef MALLOC_LATENCY
+static uint64_t stats_percentile(const uint64_t *buckets, uint64_t count, double ratio);
+#endif
+
+/**
+ * @brief Get the class an aligned size is served from, with the current
+ * zone/mmap threshold. The caller must hold the memory lock.
+ * @param size The aligned size
+ * @return The class of \a size
+ */
+stats_class_t stats_class(size_t size) {
+    if (size <= memory_g.tiny_max) {
+        return STATS_TINY;
+    }
+    if (size <= memory_g.small_max) {
+        return STATS_SMALL;
+    }
+    if (size <= memory_g.large_threshold) {
+        return STATS_MEDIUM;
+    }
+    return STATS_LARGE;
+}
+
+/**
+ * @brief Get the bytes mapped by every class of the heap of the calling
+ * thread. The caller must hold its lock.
+ * @return The mapped bytes, metadata included
+ */
+size_t stats_mapped(void) {
+    size_t mapped = 0;
+
+    for (size_t i = 0; i < STATS_CLASS_COUNT; i++) {
+        mapped += memory_g.stats[i].mapped;
+    }
+    return mapped;
+}
+
+/**
+ * @brief Copy the counters of a class
+ * @param class The class
+ * @param stats Filled with the counters of \a class
+ */
+void stats_get(stats_class_t class, stats_t *stats) {
+    memory_lock();
+    *stats = memory_g.stats[class];
+    memory_unlock();
+}
+
+/**
+ * @brief Get the size of the biggest free chunk of a class, in O(zones).
+ * Zones only keep an upper bound, which is exact once a search failed in them,
+ * so the result is capped by the highest non-empty histogram bucket.
+ * @param class The class
+ * @return An upper bound of the biggest free chunk size
+ */
+size_t stats_max_free(stats_class_t class) {
+    const stats_t *stats = &memory_g.stats[class];
+    size_t max_free = 0;
+    size_t bucket_max = 0;
+    zone_t zone;
+
+    memory_lock();
+    for (zone = stats_zone_head(class); zone; zone = zone->next) {
+        if (zone->max_free > max_free) {
+            max_free = zone->max_free;
+        }
+    }
+    for (size_t i = STATS_BUCKET_COUNT; i > 0; i--) {
+        if (stats->free_histogram[i - 1]) {
+            bucket_max = i == STATS_BUCKET_COUNT ? SIZE_MAX : ((size_t)1 << i) - 1;
+            break;
+        }
+    }
+    memory_unlock();
+    return max_free < bucket_max ? max_free : bucket_max;
+}
+
+/**
+ * @brief External fragmentation: the part of the free memory of a class that
+ * can't be used by a single allocation
+ * @param class The class
+ * @return 1 - biggest free chunk / free bytes, 0 when nothing is free
+ */
+double stats_external_fragmentation(stats_class_t class) {
+    const size_t max_free = stats_max_free(class);
+    size_t free_size;
+
+    memory_lock();
+    free_size = memory_g.stats[class].free_size;
+    memory_unlock();
+    if (free_size == 0) {
+        return 0;
+    }
+    return 1 - (double)max_free / free_size;
+}
+
+/**
+ * @brief Internal fragmentation: the part of the bytes given for the requests
+ * of a class spent on headers, alignment and class rounding
+ * @param class The class
+ * @return 1 - requested bytes / granted bytes, 0 before the first request
+ */
+double stats_internal_fragmentation(stats_class_t class) {
+    stats_t stats;
+
+    stats_get(class, &stats);
+    if (stats.granted == 0) {
+        return 0;
+    }
+    return 1 - (double)stats.requested / stats.granted;
+}
+
+/**
+ * @brief Account a new zone, or a new large mapping when \a zone_head is NULL.
+ * The hooks below must be called with the memory lock held.
+ * @param zone_head The head of the zone list, NULL for a large mapping
+ * @param size The size mapped, metadata included
+ */
+void stats_zone_add(zone_t *zone_head, size_t size) {
+    stats_t *stats = stats_of(zone_head);
+
+    stats->zone_count++;
+    stats->mapped += size;
+    if (stats->zone_count > stats->peak_zone_count) {
+        stats->peak_zone_count = stats->zone_count;
+    }
+    if (stats->mapped > stats->peak_mapped) {
+        stats->peak_mapped = stats->mapped;
+    }
+}
+
+void stats_zone_remove(zone_t *zone_head, size_t size) {
+    stats_t *stats = stats_of(zone_head);
+
+    stats->zone_count--;
+    stats->mapped -= size;
+}
+
+void stats_used_add(zone_t *zone_head, size_t size) {
+    stats_t *stats = stats_of(zone_head);
+
+    stats->used_count++;
+    stats->used_size += size;
+    if (stats->used_size + stats->used_count * CHUNK_METADATA_SIZE > stats->peak_used) {
+        stats->peak_used = stats->used_size + stats->used_count * CHUNK_METADATA_SIZE;
+    }
+}
+
+void stats_used_remove(zone_t *zone_head, size_t size) {
+    stats_t *stats = stats_of(zone_head);
+
+    stats->used_count--;
+    stats->used_size -= size;
+}
+
+void stats_free_add(zone_t *zone_head, size_t size) {
+    stats_t *stats = stats_of(zone_head);
+
+    stats->free_count++;
+    stats->free_size += size;
+    stats->free_histogram[stats_bucket(size)]++;
+}
+
+void stats_free_remove(zone_t *zone_head, size_t size) {
+    stats_t *stats = stats_of(zone_head);
+
+    stats->free_count--;
+    stats->free_size -= size;
+    stats->free_histogram[stats_bucket(size)]--;
+}
+
+/**
+ * @brief Account a request served by \a chunk
+ * @param requested The size asked by the caller, before alignment
+ * @param chunk The chunk given
+ */
+void stats_request(size_t requested, chunk_t chunk) {
+    stats_t *stats = &memory_g.stats[stats_class(ALIGN_MEM(requested))];
+
+    stats->requested += requested;
+    stats->granted += chunk->size + CHUNK_METADATA_SIZE;
+    class_record(requested);
+}
+
+/**
+ * @brief Get the latency percentiles of \a op in \a path, summed over every
+ * thread since latency_enable
+ * @param latency Set to the percentiles, zeroed when nothing was recorded
+ * @return false if the library was built without MALLOC_LATENCY
+ */
+bool stats_latency(latency_op_t op, latency_path_t path, stats_latency_t *latency) {
+#ifdef MALLOC_LATENCY
+    uint64_t buckets[LATENCY_BUCKET_COUNT];
+    uint64_t count = 0;
+
+    latency_collect(op, path, buckets);
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        count += buckets[i];
+    }
+    *latency = (stats_latency_t){
+        .count = count,
+        .p50 = stats_percentile(buckets, count, 0.5),
+        .p99 = stats_percentile(buckets, count, 0.99),
+        .p999 = stats_percentile(buckets, count, 0.999),
+        .max = stats_percentile(buckets, count, 1),
+    };
+    return true;
+#else
+    (void)op;
+    (void)path;
+    *latency = (stats_latency_t){0};
+    return false;
+#endif
+}
+
+/**
+ * @brief Get the counters of the class of \a zone_head, the large class for NULL
+ */
+stats_t *stats_of(zone_t *zone_head) {
+    if (zone_head == &memory_g.tiny_head) {
+        return &memory_g.stats[STATS_TINY];
+    }
+    if (zone_head == &memory_g.small_head) {
+        return &memory_g.stats[STATS_SMALL];
+    }
+    if (zone_head == &memory_g.medium_head) {
+        return &memory_g.stats[STATS_MEDIUM];
+    }
+    return &memory_g.stats[STATS_LARGE];
+}
+
+static zone_t stats_zone_head(stats_class_t class) {
+    switch (class) {
+        case STATS_TINY:
+            return memory_g.tiny_head;
+        case STATS_SMALL:
+            return memory_g.small_head;
+        case STATS_MEDIUM:
+            return memory_g.medium_head;
+        default:
+            return NULL;
+    }
+}
+
+static size_t stats_bucket(size_t size) {
+    return size ? sizeof(size_t) * 8 - 1 - __builtin_clzl(size) : 0;
+}
+
+#ifdef MALLOC_LATENCY
+/**
+ * @brief Get the latency under which \a ratio of the \a count calls fell
+ */
+static uint64_t stats_percentile(const uint64_t *buckets, uint64_t count, double ratio) {
+    const uint64_t rank = count * ratio + 0.5;
+    uint64_t seen = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank && buckets[i] != 0) {
+            return latency_bucket_value(i);
+        }
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,166 @@
+#include "tree.h"
+
+#include <stdint.h>
+
+static chunk_t  tree_insert_node(chunk_t root, chunk_t chunk);
+static chunk_t  tree_remove_node(chunk_t root, chunk_t chunk);
+static chunk_t  tree_remove_min(chunk_t root, chunk_t *min);
+static chunk_t  tree_balance(chunk_t root);
+static chunk_t  tree_rotate_left(chunk_t root);
+static chunk_t  tree_rotate_right(chunk_t root);
+static void     tree_update_height(chunk_t root);
+static int      tree_compare(chunk_t a, chunk_t b);
+
+/**
+ * @brief Insert a free chunk in a size ordered AVL tree, chunks of the same
+ * size are ordered by address
+ * @param root The root of the tree
+ * @param chunk The chunk to insert, of at least TREE_MIN_SIZE bytes
+ */
+void tree_insert(chunk_t *root, chunk_t chunk) {
+    TREE_SET_LEFT(chunk, NULL);
+    TREE_SET_RIGHT(chunk, NULL);
+    TREE_NODE(chunk)->height = 1;
+    *root = tree_insert_node(*root, chunk);
+}
+
+/**
+ * @brief Remove a chunk from the tree. \a chunk->size must not have changed
+ * since it was inserted.
+ * @param root The root of the tree
+ * @param chunk The chunk to remove
+ */
+void tree_remove(chunk_t *root, chunk_t chunk) {
+    *root = tree_remove_node(*root, chunk);
+}
+
+/**
+ * @brief Search the best fit for \a size in O(log n)
+ * @param root The root of the tree
+ * @param size The size searched
+ * @return The smallest chunk that can contain \a size, the lowest address one
+ * if several chunks have the same size. NULL if no chunk is wide enough.
+ */
+chunk_t tree_search(chunk_t root, size_t size) {
+    chunk_t best = NULL;
+
+    while (root) {
+        if (root->size >= size) {
+            best = root;
+            root = TREE_LEFT(root);
+        } else {
+            root = TREE_RIGHT(root);
+        }
+    }
+    return best;
+}
+
+size_t tree_height(chunk_t root) {
+    return root ? TREE_NODE(root)->height : 0;
+}
+
+static chunk_t tree_insert_node(chunk_t root, chunk_t chunk) {
+    if (root == NULL) {
+        return chunk;
+    }
+    if (tree_compare(chunk, root) < 0) {
+        TREE_SET_LEFT(root, tree_insert_node(TREE_LEFT(root), chunk));
+    } else {
+        TREE_SET_RIGHT(root, tree_insert_node(TREE_RIGHT(root), chunk));
+    }
+    return tree_balance(root);
+}
+
+static chunk_t tree_remove_node(chunk_t root, chunk_t chunk) {
+    chunk_t successor;
+    int cmp;
+
+    if (root == NULL) {
+        return NULL;
+    }
+    cmp = tree_compare(chunk, root);
+    if (cmp < 0) {
+        TREE_SET_LEFT(root, tree_remove_node(TREE_LEFT(root), chunk));
+    } else if (cmp > 0) {
+        TREE_SET_RIGHT(root, tree_remove_node(TREE_RIGHT(root), chunk));
+    } else {
+        if (TREE_LEFT(root) == NULL) {
+            return TREE_RIGHT(root);
+        }
+        if (TREE_RIGHT(root) == NULL) {
+            return TREE_LEFT(root);
+        }
+        //The removed node is replaced by its in-order successor
+        TREE_SET_RIGHT(root, tree_remove_min(TREE_RIGHT(root), &successor));
+        TREE_SET_LEFT(successor, TREE_LEFT(root));
+        TREE_SET_RIGHT(successor, TREE_RIGHT(root));
+        root = successor;
+    }
+    return tree_balance(root);
+}
+
+static chunk_t tree_remove_min(chunk_t root, chunk_t *min) {
+    if (TREE_LEFT(root) == NULL) {
+        *min = root;
+        return TREE_RIGHT(root);
+    }
+    TREE_SET_LEFT(root, tree_remove_min(TREE_LEFT(root), min));
+    return tree_balance(root);
+}
+
+static chunk_t tree_balance(chunk_t root) {
+    long balance;
+
+    tree_update_height(root);
+    balance = (long)tree_height(TREE_LEFT(root)) - (long)tree_height(TREE_RIGHT(root));
+    if (balance > 1) {
+        if (tree_height(TREE_LEFT(TREE_LEFT(root))) < tree_height(TREE_RIGHT(TREE_LEFT(root)))) {
+            TREE_SET_LEFT(root, tree_rotate_left(TREE_LEFT(root)));
+        }
+        return tree_rotate_right(root);
+    }
+    if (balance < -1) {
+        if (tree_height(TREE_RIGHT(TREE_RIGHT(root))) < tree_height(TREE_LEFT(TREE_RIGHT(root)))) {
+            TREE_SET_RIGHT(root, tree_rotate_right(TREE_RIGHT(root)));
+        }
+        return tree_rotate_left(root);
+    }
+    return root;
+}
+
+static chunk_t tree_rotate_left(chunk_t root) {
+    chunk_t pivot = TREE_RIGHT(root);
+
+    TREE_SET_RIGHT(root, TREE_LEFT(pivot));
+    TREE_SET_LEFT(pivot, root);
+    tree_update_height(root);
+    tree_update_height(pivot);
+    return pivot;
+}
+
+static chunk_t tree_rotate_right(chunk_t root) {
+    chunk_t pivot = TREE_LEFT(root);
+
+    TREE_SET_LEFT(root, TREE_RIGHT(pivot));
+    TREE_SET_RIGHT(pivot, root);
+    tree_update_height(root);
+    tree_update_height(pivot);
+    return pivot;
+}
+
+static void tree_update_height(chunk_t root) {
+    const size_t left = tree_height(TREE_LEFT(root));
+    const size_t right = tree_height(TREE_RIGHT(root));
+
+    TREE_NODE(root)->height = (left > right ? left : right) + 1;
+}
+
+static int tree_compare(chunk_t a, chunk_t b) {
+    if (a->size != b->size) {
+        return a->size < b->size ? -1 : 1;
+    }
+    if (a != b) {
+        return (uintptr_t)a < (uintptr_t)b ? -1 : 1;
+    }
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "utils.h"
 
 #include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
 #include <sys/mman.h>
 
 void *mmap_wrapper(size_t size) {
@@ -17,4 +19,24 @@ void *mmap_wrapper(size_t size) {
         return NULL;
     }
     return ret;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Fault in every page of a fresh mapping, so that the first writes to
+ * it don't trap. Pages are touched one by one when the kernel doesn't know
+ * MADV_POPULATE_WRITE (before Linux 5.14).
+ * @param addr The start of the mapping
+ * @param size The size of the mapping
+ */
+void mmap_prefault(void *addr, size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(addr, size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    for (size_t i = 0; i < size; i += page_size) {
+        ((volatile uint8_t*)addr)[i] = ((volatile uint8_t*)addr)[i];
+    }
+}
@@ -3,93 +3,310 @@
 #include <unistd.h>
 #include <sys/mman.h>
 #include "chunk.h"
+#include "latency.h"
+#include "limit.h"
+#include "memory.h"
 #include "utils.h"
+#include "stats.h"
+
+static zone_t  zone_create(zone_t last, size_t zone_size);
+static chunk_t zone_search_chunk(zone_t zone, size_t size);
+static void    zone_forget_rover(zone_t zone);
 
 /**
- * @brief Create a new zone
+ * @brief Create a new zone, of the smallest size holding \a chunk_size
  * @param last The last zone search, new zone will be placed next
  * @param chunk_size The chunk size that will be placed in the zone
  * @return The newly created zone
  */
 zone_t zone_new(zone_t last, size_t chunk_size) {
-    zone_t new_zone;
-    size_t zone_size;
+    return zone_create(last, zone_mapping_size(chunk_size));
+}
+
+/**
+ * @brief Create the next zone of a class, sized by zone_growth_size. When the
+ * bigger zone can't be mapped, e.g. near the limit, the smallest zone holding
+ * \a chunk_size is tried instead.
+ * @param zone_head The head of the zone list of the class
+ * @param last The last zone search, new zone will be placed next
+ * @param chunk_size The chunk size that will be placed in the zone
+ * @return The newly created zone
+ */
+zone_t zone_grow(zone_t *zone_head, zone_t last, size_t chunk_size) {
+    const size_t zone_size = zone_growth_size(zone_head, chunk_size);
+    zone_t new_zone = NULL;
+
+    if (zone_size > zone_mapping_size(chunk_size)) {
+        new_zone = zone_create(last, zone_size);
+    }
+    return new_zone != NULL ? new_zone : zone_new(last, chunk_size);
+}
+
+/**
+ * @brief Get the size of the next zone of a class: the smallest one until
+ * the class maps ZONE_GROWTH_RATIO times that, then a 1/ZONE_GROWTH_RATIO
+ * of what it maps, up to ZONE_GROWTH_MAX. Zones grow geometrically with the
+ * class, and shrink back as it gives zones back.
+ * @param zone_head The head of the zone list of the class
+ * @param chunk_size The chunk size that will be placed in the zone
+ * @return The size of the mapping, 0 if \a chunk_size is above the zones
+ */
+size_t zone_growth_size(zone_t *zone_head, size_t chunk_size) {
     const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t min_size = zone_mapping_size(chunk_size);
+    size_t zone_size;
 
-    if (chunk_size <= TINY_CHUNK_SIZE) {
-        zone_size = TINY_CHUNK_SIZE * CHUNK_PER_ZONE + ZONE_METADATA_SIZE;
-    } else if (chunk_size <= SMALL_CHUNK_SIZE) {
-        zone_size = SMALL_CHUNK_SIZE * CHUNK_PER_ZONE + ZONE_METADATA_SIZE;
-    } else {
+    zone_size = stats_of(zone_head)->mapped / ZONE_GROWTH_RATIO;
+    if (zone_size > ZONE_GROWTH_MAX) {
+        zone_size = ZONE_GROWTH_MAX;
+    }
+    if (min_size == 0 || zone_size <= min_size) {
+        return min_size;
+    }
+    return zone_size - zone_size % page_size;
+}
+
+/**
+ * @brief Map a zone of \a zone_size bytes and link it after \a last
+ * @return The new zone, NULL if it would go over the limit or couldn't be mapped
+ */
+static zone_t zone_create(zone_t last, size_t zone_size) {
+    zone_t new_zone;
+
+    if (zone_size == 0 || !limit_check(zone_size)) {
         return NULL;
     }
-    zone_size += page_size - zone_size % page_size;
-    new_zone = mmap_wrapper(zone_size);
+    latency_mark(LATENCY_PATH_GROWTH);
+    new_zone = zone_map(zone_size);
     if (new_zone == NULL) {
         return NULL;
     }
     if (last != NULL) {
         last->next = new_zone;
     }
+    return new_zone;
+}
+
+/**
+ * @brief Get the size of the mapping of a zone holding chunks of \a chunk_size
+ * @param chunk_size The chunk size that will be placed in the zone
+ * @return The size of the mapping, 0 if \a chunk_size is above the zones
+ */
+size_t zone_mapping_size(size_t chunk_size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t medium_size;
+    size_t zone_size;
+
+    if (chunk_size <= memory_g.tiny_max) {
+        zone_size = memory_g.tiny_max * CHUNK_PER_ZONE + ZONE_METADATA_SIZE;
+    } else if (chunk_size <= memory_g.small_max) {
+        zone_size = memory_g.small_max * CHUNK_PER_ZONE + ZONE_METADATA_SIZE;
+    } else if (chunk_size <= chunk_round_size(memory_g.large_threshold)) {
+        //Medium chunks are page-rounded with their metadata, see chunk_round_size
+        medium_size = MEDIUM_CHUNK_SIZE + CHUNK_METADATA_SIZE + page_size - 1;
+        zone_size = (medium_size - medium_size % page_size) * MEDIUM_CHUNK_PER_ZONE;
+        //Above MEDIUM_CHUNK_SIZE, the zone holds at least two chunks
+        if (zone_size < (chunk_size + CHUNK_METADATA_SIZE) * 2) {
+            zone_size = (chunk_size + CHUNK_METADATA_SIZE) * 2;
+        }
+        zone_size += ZONE_METADATA_SIZE;
+    } else {
+        return 0;
+    }
+    return zone_size + page_size - zone_size % page_size;
+}
+
+/**
+ * @brief Map a zone holding a single free chunk, not linked to any list.
+ * Doesn't need the memory lock.
+ * @param zone_size The size of the mapping, see zone_mapping_size
+ * @return The new zone, NULL if it couldn't be mapped
+ */
+zone_t zone_map(size_t zone_size) {
+    zone_t new_zone;
+
+    new_zone = mmap_wrapper(zone_size);
+    if (new_zone == NULL) {
+        return NULL;
+    }
+    if (memory_g.config->prefault) {
+        mmap_prefault(new_zone, zone_size);
+    }
     new_zone->next = NULL;
     new_zone->size = zone_size - ZONE_METADATA_SIZE;
+    new_zone->free_size = new_zone->size;
     //Now we add free chunk of the size of the remaining space
     chunk_t new_chunk = zone_get_chunk(new_zone);
     chunk_init(new_chunk, zone_size - ZONE_METADATA_SIZE - CHUNK_METADATA_SIZE);
     new_chunk->free = 1;
+    new_zone->max_free = new_chunk->size;
     return new_zone;
 }
 
 /**
  * @brief Unmap the second free zone found, ensuring that at least one free zone
- * remain
+ * remain. Reserved zones are skipped, see zone_reserved
  * @param zone_head The zone head to update if it is unmapped
  */
 void zone_unmap(zone_t* zone_head) {
-    zone_t it = *zone_head;
-    zone_t prev = NULL;
     uint8_t zone_found = 0;
 
-    while (it) {
-        chunk_t chunk = (chunk_t)it->data;
-        if (it->size == chunk->size + CHUNK_METADATA_SIZE && chunk->free) {
-            //The zone is free
-            if (zone_found) {
-                if (prev == NULL) {
-                    *zone_head = it->next;
-                }
-                else {
-                    prev->next = it->next;
-                }
+    for (zone_t it = *zone_head; it; it = it->next) {
+        if (zone_empty(it)) {
+            if (zone_found && !zone_reserved(zone_head, it)) {
+                zone_remove(zone_head, it);
+                latency_mark(LATENCY_PATH_SYSCALL);
                 munmap(it, it->size);
                 return;
             }
             zone_found = 1;
         }
-        prev = it;
-        it = it->next;
     }
 }
 
 /**
- * @brief Search a zone list to find a chunk wide enough to contain size
+ * @brief Unmap every empty zone, including the one zone_unmap keeps
+ * @param zone_head The zone head to update if it is unmapped
+ */
+void zone_trim(zone_t *zone_head) {
+    zone_t it = *zone_head;
+    zone_t next;
+
+    while (it) {
+        next = it->next;
+        if (zone_empty(it)) {
+            zone_remove(zone_head, it);
+            latency_mark(LATENCY_PATH_SYSCALL);
+            munmap(it, it->size + ZONE_METADATA_SIZE);
+        }
+        it = next;
+    }
+}
+
+/**
+ * @brief Unlink \a zone from its list, without unmapping it
+ * @param zone_head The head of the zone list
+ * @param zone An empty zone
+ * @return false if \a zone isn't in the list
+ */
+bool zone_remove(zone_t *zone_head, zone_t zone) {
+    zone_t *it = zone_head;
+
+    while (*it != NULL && *it != zone) {
+        it = &(*it)->next;
+    }
+    if (*it == NULL) {
+        return false;
+    }
+    *it = zone->next;
+    chunk_tree_remove(zone_head, zone_get_chunk(zone));
+    stats_zone_remove(zone_head, zone->size + ZONE_METADATA_SIZE);
+    zone_forget_rover(zone);
+    return true;
+}
+
+/**
+ * @brief Check that \a zone holds a single free chunk
+ */
+bool zone_empty(zone_t zone) {
+    const chunk_t chunk = zone_get_chunk(zone);
+
+    return chunk->free && zone->size == chunk->size + CHUNK_METADATA_SIZE;
+}
+
+/**
+ * @brief Check whether the empty \a zone must stay mapped, because its class
+ * would go below the bytes reserved for it by profile_prewarm. The reserve is
+ * dropped once the class used as many bytes: the peak it was kept for came.
+ * @param zone_head The head of the zone list containing \a zone
+ */
+bool zone_reserved(zone_t *zone_head, zone_t zone) {
+    const stats_t *stats = stats_of(zone_head);
+    size_t *reserved = &memory_g.reserved[stats - memory_g.stats];
+
+    if (*reserved != 0 && stats->peak_used + stats->zone_count * ZONE_METADATA_SIZE >= *reserved) {
+        *reserved = 0;
+    }
+    return *reserved != 0 && stats->mapped < *reserved + zone->size + ZONE_METADATA_SIZE;
+}
+
+/**
+ * @brief Search a zone list to find a chunk wide enough to contain size.
+ * The search starts from the zone where the last one stopped, wraps around the
+ * list, and skips the zones whose biggest free chunk is known to be too small.
  * @param z_head head of zones to search
- * @param z_last last zone checked
+ * @param z_rover zone to start from, updated to the zone the chunk was found in
+ * @param z_last last zone of the list, set if the end of the list was reached
+ * @param size size searched
+ * @return the first chunk found, NULL if no chunk fit we found
+ */
+chunk_t zone_search(zone_t z_head, zone_t *z_rover, zone_t *z_last, size_t size) {
+    const zone_t start = *z_rover != NULL ? *z_rover : z_head;
+    zone_t it = start;
+    chunk_t chunk;
+
+    while (it) {
+        if (it->max_free >= size) {
+            chunk = zone_search_chunk(it, size);
+            if (chunk != NULL) {
+                *z_rover = it;
+                return chunk;
+            }
+        }
+        if (it->next == NULL) {
+            *z_last = it;
+            it = z_head;
+        } else {
+            it = it->next;
+        }
+        if (it == start) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Search the chunks of a zone for a free chunk wide enough to contain
+ * size. When none is found, zone->max_free is set to the exact biggest free
+ * chunk size so that the next searches skip this zone.
+ * @param zone The zone to search
  * @param size size searched
  * @return the first chunk found, NULL if no chunk fit we found
  */
-chunk_t zone_search(zone_t z_head, zone_t *z_last, size_t size) {
-    while (z_head) {
-        chunk_t chunk = chunk_search(zone_get_chunk(z_head), size);
-        if (chunk != NULL) {
-            return chunk;
+static chunk_t zone_search_chunk(zone_t zone, size_t size) {
+    chunk_t chunk = zone_get_chunk(zone);
+    size_t max_free = 0;
+
+    while (chunk) {
+        if (chunk->free) {
+            if (chunk->size >= size) {
+                return chunk;
+            }
+            if (chunk->size > max_free) {
+                max_free = chunk->size;
+            }
         }
-        *z_last = z_head;
-        z_head = z_head->next;
+        chunk = chunk->next;
     }
+    zone->max_free = max_free;
     return NULL;
 }
 
+/**
+ * @brief Make sure no rover points to a zone about to be unmapped
+ * @param zone The zone to unmap
+ */
+static void zone_forget_rover(zone_t zone) {
+    zone_t *rovers[] = {&memory_g.tiny_rover, &memory_g.small_rover, &memory_g.medium_rover};
+
+    for (size_t i = 0; i < sizeof(rovers) / sizeof(*rovers); i++) {
+        if (*rovers[i] == zone) {
+            *rovers[i] = NULL;
+        }
+    }
+}
+
 zone_t  zone_validate(uintptr_t addr, zone_t head) {
     while (head) {
         if (addr >= (uintptr_t)head->data && addr < (uintptr_t)head->data + head->size) {
@@ -0,0 +1,131 @@
+#include "unity.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "aligned.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "cache.h"
+#include "quick.h"
+#include "def.h"
+#include "stats.h"
+
+void test_aligned_zone(void);
+void test_aligned_large(void);
+void test_aligned_invalid(void);
+void test_aligned_free_sized(void);
+
+static void aligned_flush(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_aligned_zone);
+    RUN_TEST(test_aligned_large);
+    RUN_TEST(test_aligned_invalid);
+    RUN_TEST(test_aligned_free_sized);
+
+    return UNITY_END();
+}
+
+void test_aligned_zone(void) {
+    //stdout may hold a buffer in the small class
+    const size_t small_count = memory_g.stats[STATS_SMALL].used_count;
+    void *addrs[64];
+    size_t alignment;
+    zone_t zone;
+
+    for (size_t i = 0; i < 64; i++) {
+        alignment = (size_t)32 << (i % 6);
+        addrs[i] = aligned_alloc(alignment, 8 + i * 24);
+        TEST_ASSERT_NOT_NULL(addrs[i]);
+        TEST_ASSERT_EQUAL(0, (uintptr_t)addrs[i] % alignment);
+        TEST_ASSERT_NOT_NULL(chunk_validate(addrs[i], &zone, NULL));
+        TEST_ASSERT_NOT_NULL(zone);
+        TEST_ASSERT_GREATER_OR_EQUAL(ALIGN_MEM(8 + i * 24), ((chunk_t)(addrs[i] - CHUNK_METADATA_SIZE))->size);
+        memset(addrs[i], 0xAB, 8 + i * 24);
+    }
+    for (size_t i = 0; i < 64; i++) {
+        free(addrs[i]);
+    }
+    aligned_flush();
+    //Every lead and trailing chunk was given back
+    TEST_ASSERT_EQUAL(0, memory_g.stats[STATS_TINY].used_count);
+    TEST_ASSERT_EQUAL(small_count, memory_g.stats[STATS_SMALL].used_count);
+}
+
+void test_aligned_large(void) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    void *addr;
+    void *ptr;
+    zone_t zone;
+
+    addr = aligned_alloc(page_size * 4, MEDIUM_CHUNK_SIZE * 8);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)addr % (page_size * 4));
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr, &zone, NULL));
+    TEST_ASSERT_NULL(zone);
+    memset(addr, 0xAB, MEDIUM_CHUNK_SIZE * 8);
+    TEST_ASSERT_EQUAL(0, posix_memalign(&ptr, 1024 * 1024, SMALL_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(0, (uintptr_t)ptr % (1024 * 1024));
+    free(addr);
+    free(ptr);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+}
+
+void test_aligned_invalid(void) {
+    void *ptr = NULL;
+
+    errno = 0;
+    TEST_ASSERT_NULL(aligned_alloc(48, 64));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    TEST_ASSERT_EQUAL(EINVAL, posix_memalign(&ptr, 4, 64));
+    TEST_ASSERT_EQUAL(EINVAL, posix_memalign(&ptr, 0, 64));
+    TEST_ASSERT_NULL(ptr);
+    //Small alignments are served like malloc
+    ptr = memalign(8, 64);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)ptr % ALIGN_SIZE);
+    free(ptr);
+}
+
+void test_aligned_free_sized(void) {
+    const size_t small_count = memory_g.stats[STATS_SMALL].used_count;
+    const size_t medium_count = memory_g.stats[STATS_MEDIUM].used_count;
+    void *tiny = malloc(TINY_CHUNK_SIZE);
+    void *small = malloc(SMALL_CHUNK_SIZE);
+    void *medium = malloc(MEDIUM_CHUNK_SIZE);
+    void *large = malloc(MEDIUM_CHUNK_SIZE * 64);
+    void *aligned = aligned_alloc(256, 16);
+
+    free_sized(tiny, TINY_CHUNK_SIZE);
+    free_sized(small, SMALL_CHUNK_SIZE);
+    free_sized(medium, MEDIUM_CHUNK_SIZE);
+    free_sized(large, MEDIUM_CHUNK_SIZE * 64);
+    //Served from a bigger class than its size
+    free_sized(aligned, 16);
+    free_sized(NULL, 16);
+    aligned_flush();
+    TEST_ASSERT_EQUAL(0, memory_g.stats[STATS_TINY].used_count);
+    TEST_ASSERT_EQUAL(small_count, memory_g.stats[STATS_SMALL].used_count);
+    TEST_ASSERT_EQUAL(medium_count, memory_g.stats[STATS_MEDIUM].used_count);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+}
+
+/**
+ * @brief The thread cache and the quick lists keep their chunks used, give
+ * them back before counting
+ */
+static void aligned_flush(void) {
+    cache_flush();
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+}
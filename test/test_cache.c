@@ -0,0 +1,189 @@
+#include "unity.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "chunk.h"
+#include "free.h"
+#include "hardening.h"
+#include "malloc.h"
+#include "memory.h"
+
+#define CACHE_THREAD_COUNT  4
+#define CACHE_THREAD_ROUNDS 10000
+#define CACHE_WAIT_ROUNDS   1000    // Of 1ms
+
+void test_cache_push_pop(void);
+void test_cache_capacity(void);
+void test_cache_reuse(void);
+void test_cache_double_free(void);
+void test_cache_lockless(void);
+void test_cache_threads(void);
+static void *cache_thread_routine(void *arg);
+static void *cache_lockless_routine(void *arg);
+static void cache_wait(atomic_int *state, int value);
+
+static atomic_int   lockless_state_g = 0;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_cache_push_pop);
+    RUN_TEST(test_cache_capacity);
+    RUN_TEST(test_cache_reuse);
+    RUN_TEST(test_cache_double_free);
+    RUN_TEST(test_cache_lockless);
+    RUN_TEST(test_cache_threads);
+
+    return UNITY_END();
+}
+
+void test_cache_push_pop(void) {
+    chunk_t chunk;
+    void *addr;
+
+    TEST_ASSERT_NOT_EQUAL(CACHE_MODE_NONE, cache_init());
+    TEST_ASSERT_NULL(cache_pop(TINY_CHUNK_SIZE));
+    addr = malloc(TINY_CHUNK_SIZE);
+    chunk = addr - CHUNK_METADATA_SIZE;
+    TEST_ASSERT_TRUE(cache_push(chunk));
+    //The chunk must still look used to the zone
+    TEST_ASSERT_FALSE(chunk->free);
+    TEST_ASSERT_EQUAL(chunk, cache_pop(TINY_CHUNK_SIZE));
+    TEST_ASSERT_NULL(cache_pop(TINY_CHUNK_SIZE));
+    //Only tiny chunks are cached
+    TEST_ASSERT_NULL(cache_pop(SMALL_CHUNK_SIZE));
+    free(addr);
+}
+
+void test_cache_capacity(void) {
+    chunk_t chunks[CACHE_BIN_CAPACITY + 1];
+
+    for (size_t i = 0; i <= CACHE_BIN_CAPACITY; i++) {
+        chunks[i] = (chunk_t)(malloc(TINY_CHUNK_SIZE / 2) - CHUNK_METADATA_SIZE);
+    }
+    for (size_t i = 0; i < CACHE_BIN_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(cache_push(chunks[i]));
+    }
+    TEST_ASSERT_FALSE(cache_push(chunks[CACHE_BIN_CAPACITY]));
+    cache_flush();
+    TEST_ASSERT_NULL(cache_pop(TINY_CHUNK_SIZE / 2));
+    for (size_t i = 0; i < CACHE_BIN_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(chunks[i]->free);
+    }
+    free((void*)chunks[CACHE_BIN_CAPACITY] + CHUNK_METADATA_SIZE);
+}
+
+void test_cache_reuse(void) {
+#ifdef MALLOC_CACHE
+    void *addr = malloc(TINY_CHUNK_SIZE);
+
+    free(addr);
+    TEST_ASSERT_EQUAL(addr, malloc(TINY_CHUNK_SIZE));
+    free(addr);
+    cache_flush();
+#else
+    TEST_IGNORE_MESSAGE("MALLOC_CACHE is disabled");
+#endif
+}
+
+void test_cache_double_free(void) {
+#if defined(MALLOC_CACHE) && HARDENING_CHECK
+    void *addr = malloc(TINY_CHUNK_SIZE);
+    void *first;
+    void *second;
+
+    free(addr);
+    //Caught although the chunk still looks used
+    free(addr);
+    first = malloc(TINY_CHUNK_SIZE);
+    second = malloc(TINY_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(addr, first);
+    TEST_ASSERT_NOT_EQUAL(first, second);
+    free(second);
+    free(first);
+    cache_flush();
+#else
+    TEST_IGNORE_MESSAGE("MALLOC_CACHE is disabled or the caller is trusted");
+#endif
+}
+
+void test_cache_lockless(void) {
+#ifdef MALLOC_CACHE
+    pthread_t thread;
+    int state;
+
+    TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, cache_lockless_routine, NULL));
+    cache_wait(&lockless_state_g, 1);
+    //A free the cache takes must not wait for the lock
+    memory_lock();
+    atomic_store(&lockless_state_g, 2);
+    cache_wait(&lockless_state_g, 3);
+    state = atomic_load(&lockless_state_g);
+    memory_unlock();
+    TEST_ASSERT_EQUAL(0, pthread_join(thread, NULL));
+    TEST_ASSERT_EQUAL(3, state);
+#else
+    TEST_IGNORE_MESSAGE("MALLOC_CACHE is disabled");
+#endif
+}
+
+void test_cache_threads(void) {
+    pthread_t threads[CACHE_THREAD_COUNT];
+    void *ret;
+
+    for (size_t i = 0; i < CACHE_THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, cache_thread_routine, NULL));
+    }
+    for (size_t i = 0; i < CACHE_THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_join(threads[i], &ret));
+        TEST_ASSERT_NULL(ret);
+    }
+}
+
+static void *cache_thread_routine(void *arg) {
+    void *addr[8];
+
+    (void)arg;
+    for (size_t round = 0; round < CACHE_THREAD_ROUNDS; round++) {
+        for (size_t i = 0; i < 8; i++) {
+            addr[i] = malloc((i + 1) * ALIGN_SIZE);
+            ((uint8_t*)addr[i])[0] = i;
+        }
+        for (size_t i = 0; i < 8; i++) {
+            //Asserting from another thread is not supported by unity
+            if (((uint8_t*)addr[i])[0] != i) {
+                return addr[i];
+            }
+            free(addr[i]);
+        }
+    }
+    return NULL;
+}
+
+static void *cache_lockless_routine(void *arg) {
+    //Also gives the thread its cache
+    void *addr = malloc(TINY_CHUNK_SIZE);
+
+    (void)arg;
+    atomic_store(&lockless_state_g, 1);
+    cache_wait(&lockless_state_g, 2);
+    free(addr);
+    atomic_store(&lockless_state_g, 3);
+    cache_flush();
+    return NULL;
+}
+
+/**
+ * @brief Wait up to CACHE_WAIT_ROUNDS ms for \a state to reach \a value
+ */
+static void cache_wait(atomic_int *state, int value) {
+    for (size_t i = 0; i < CACHE_WAIT_ROUNDS && atomic_load(state) != value; i++) {
+        usleep(1000);
+    }
+}
@@ -65,6 +65,8 @@ void test_chunk_fusion_prev_free(void) {
     chunk->prev = prev;
     prev->next = chunk;
     prev->free = 1;
+    chunk_seal(chunk);
+    chunk_seal(prev);
     chunk_fusion(chunk);
     TEST_ASSERT_EQUAL(CHUNK_SIZE + PREV_SIZE + CHUNK_METADATA_SIZE, prev->size);
     TEST_ASSERT_EQUAL(NULL, prev->next);
@@ -84,6 +86,8 @@ void test_chunk_fusion_prev_not_free(void) {
     chunk->prev = prev;
     prev->next = chunk;
     prev->free = 0;
+    chunk_seal(chunk);
+    chunk_seal(prev);
     chunk_fusion(chunk);
     TEST_ASSERT_EQUAL(CHUNK_SIZE, chunk->size);
     TEST_ASSERT_EQUAL(PREV_SIZE, prev->size);
@@ -106,6 +110,8 @@ void test_chunk_fusion_next_free(void) {
     chunk->next = next;
     next->prev = chunk;
     next->free = 1;
+    chunk_seal(chunk);
+    chunk_seal(next);
     chunk_fusion(chunk);
     TEST_ASSERT_EQUAL(CHUNK_SIZE + NEXT_SIZE + CHUNK_METADATA_SIZE, chunk->size);
     TEST_ASSERT_EQUAL(NULL, chunk->next);
@@ -125,6 +131,8 @@ void test_chunk_fusion_next_not_free(void) {
     chunk->next = next;
     next->prev = chunk;
     next->free = 0;
+    chunk_seal(chunk);
+    chunk_seal(next);
     chunk_fusion(chunk);
     TEST_ASSERT_EQUAL(CHUNK_SIZE, chunk->size);
     TEST_ASSERT_EQUAL(NEXT_SIZE, next->size);
@@ -7,7 +7,7 @@
 #include "chunk.h"
 #include "def.h"
 
-#define LARGE_CHUNK_SIZE (SMALL_CHUNK_SIZE * 8)
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 2)
 #define TINY_CHUNK_SIZE_1_1 TINY_CHUNK_SIZE
 #define TINY_CHUNK_SIZE_1_2 (TINY_CHUNK_SIZE / 2)
 #define SMALL_CHUNK_SIZE_1_1 SMALL_CHUNK_SIZE
@@ -55,5 +55,9 @@ static void chunk_init_test(chunk_t chunk, size_t size) {
     TEST_ASSERT_NULL(chunk->prev);
     TEST_ASSERT_EQUAL(chunk->free, 0);
     TEST_ASSERT_EQUAL(chunk->data, (void*)chunk + CHUNK_METADATA_SIZE);
+#ifdef MALLOC_HARDENING_HARDENED
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+#else
     TEST_ASSERT_EQUAL((chunk->magic >> 8), chunk->data);
+#endif
 }
@@ -90,7 +90,11 @@ static void chunk_split_test(chunk_t chunk, size_t new_size) {
     TEST_ASSERT_EQUAL(new_chunk->size, old_size - new_size - CHUNK_METADATA_SIZE);
     TEST_ASSERT_EQUAL(new_chunk->prev, chunk);
     TEST_ASSERT_EQUAL(new_chunk->next, next);
+#ifdef MALLOC_HARDENING_HARDENED
+    TEST_ASSERT_TRUE(chunk_check(new_chunk));
+#else
     TEST_ASSERT_EQUAL((new_chunk->magic >> 8), new_chunk->data);
+#endif
     TEST_ASSERT_EQUAL(new_chunk->free, 1);
     if (next) {
         TEST_ASSERT_EQUAL(new_chunk, next->prev);
@@ -0,0 +1,102 @@
+#include "unity.h"
+
+#include <unistd.h>
+
+#include "class.h"
+#include "heap.h"
+#include "chunk.h"
+#include "config.h"
+#include "memory.h"
+#include "stats.h"
+#include "def.h"
+
+#define CLASS_MEDIUM_REQUEST    5000    // Rounded to two pages in the medium class
+#define CLASS_TINY_REQUEST      200     // Small, but would fit a bigger tiny class
+
+void test_class_disabled(void);
+void test_class_small_grows(void);
+void test_class_tiny_fixed(void);
+
+static void class_churn(heap_t heap, size_t size, size_t count);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_class_disabled);
+    RUN_TEST(test_class_small_grows);
+    RUN_TEST(test_class_tiny_fixed);
+
+    return UNITY_END();
+}
+
+void test_class_disabled(void) {
+    heap_t heap = heap_create(NULL);
+
+    TEST_ASSERT_NOT_NULL(heap);
+    class_churn(heap, CLASS_MEDIUM_REQUEST, CLASS_TUNE_PERIOD);
+    TEST_ASSERT_EQUAL(TINY_CHUNK_SIZE, heap->memory.tiny_max);
+    TEST_ASSERT_EQUAL(SMALL_CHUNK_SIZE, heap->memory.small_max);
+    TEST_ASSERT_EQUAL(0, heap->memory.classes.tunings);
+    heap_destroy(heap);
+}
+
+void test_class_small_grows(void) {
+    config_t config = config_g;
+    heap_t heap;
+    void *addr;
+
+    config.adaptive_classes = 1;
+    heap = heap_create(&config);
+    TEST_ASSERT_NOT_NULL(heap);
+    class_churn(heap, CLASS_MEDIUM_REQUEST, CLASS_TUNE_PERIOD - 1);
+    TEST_ASSERT_EQUAL(SMALL_CHUNK_SIZE, heap->memory.small_max);
+    class_churn(heap, CLASS_MEDIUM_REQUEST, 1);
+    //The small class now serves the requests instead of rounding them to pages
+    TEST_ASSERT_GREATER_OR_EQUAL(ALIGN_MEM(CLASS_MEDIUM_REQUEST), heap->memory.small_max);
+    TEST_ASSERT_LESS_OR_EQUAL(CLASS_SMALL_MAX, heap->memory.small_max);
+    TEST_ASSERT_EQUAL(1, heap->memory.classes.tunings);
+    //Every request was rounded to two pages
+    TEST_ASSERT_EQUAL(CLASS_TUNE_PERIOD * (2 * sysconf(_SC_PAGESIZE) - CHUNK_METADATA_SIZE
+                                          - ALIGN_MEM(CLASS_MEDIUM_REQUEST)),
+                      heap->memory.classes.saved);
+    addr = heap_malloc(heap, CLASS_MEDIUM_REQUEST);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_EQUAL(1, heap->memory.stats[STATS_SMALL].used_count);
+    TEST_ASSERT_EQUAL(ALIGN_MEM(CLASS_MEDIUM_REQUEST), ((chunk_t)(addr - CHUNK_METADATA_SIZE))->size);
+    heap_free(heap, addr);
+    //Nothing left to gain, the boundaries stay
+    class_churn(heap, CLASS_MEDIUM_REQUEST, CLASS_TUNE_PERIOD);
+    TEST_ASSERT_EQUAL(1, heap->memory.classes.tunings);
+    heap_destroy(heap);
+}
+
+void test_class_tiny_fixed(void) {
+    config_t config = config_g;
+    heap_t heap;
+    void *addr;
+
+    config.adaptive_classes = 1;
+    heap = heap_create(&config);
+    TEST_ASSERT_NOT_NULL(heap);
+    class_churn(heap, CLASS_TINY_REQUEST, CLASS_TUNE_PERIOD);
+    //Split to their exact size in the small zones, a bigger tiny class saves nothing
+    TEST_ASSERT_EQUAL(TINY_CHUNK_SIZE, heap->memory.tiny_max);
+    //Smaller zones are enough, and no request is rounded to pages
+    TEST_ASSERT_EQUAL(CLASS_SMALL_MIN, heap->memory.small_max);
+    TEST_ASSERT_EQUAL(1, heap->memory.classes.tunings);
+    TEST_ASSERT_EQUAL(0, heap->memory.classes.saved);
+    addr = heap_malloc(heap, CLASS_TINY_REQUEST);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_EQUAL(1, heap->memory.stats[STATS_SMALL].used_count);
+    heap_free(heap, addr);
+    heap_destroy(heap);
+}
+
+static void class_churn(heap_t heap, size_t size, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        heap_free(heap, heap_malloc(heap, size));
+    }
+}
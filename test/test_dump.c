@@ -0,0 +1,115 @@
+#define _GNU_SOURCE
+#include "unity.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "dump.h"
+#include "memory.h"
+
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 8)
+#define DUMP_READ_SIZE (1024 * 1024)
+
+void test_dump_memory(void);
+void test_dump_signal(void);
+void test_dump_busy(void);
+void test_dump_signal_busy(void);
+static size_t dump_read(int fd, char *out);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_dump_memory);
+    RUN_TEST(test_dump_signal);
+    RUN_TEST(test_dump_busy);
+    RUN_TEST(test_dump_signal_busy);
+
+    return UNITY_END();
+}
+
+void test_dump_memory(void) {
+    static char out[DUMP_READ_SIZE];
+    const int fd = memfd_create("dump", 0);
+    void *tiny = malloc(TINY_CHUNK_SIZE);
+    void *large = malloc(LARGE_CHUNK_SIZE);
+    char large_address[32];
+    size_t len;
+
+    TEST_ASSERT_EQUAL(0, dump_memory(fd));
+    len = dump_read(fd, out);
+    TEST_ASSERT_TRUE(len > 2);
+    TEST_ASSERT_EQUAL('{', out[0]);
+    TEST_ASSERT_EQUAL('}', out[len - 2]);
+    TEST_ASSERT_EQUAL('\n', out[len - 1]);
+    TEST_ASSERT_NOT_NULL(strstr(out, "\"class\":\"tiny\""));
+    snprintf(large_address, sizeof(large_address), "[\"%p\",", large - CHUNK_METADATA_SIZE);
+    TEST_ASSERT_NOT_NULL(strstr(out, large_address));
+    free(tiny);
+    free(large);
+    close(fd);
+}
+
+void test_dump_signal(void) {
+    static char out[DUMP_READ_SIZE];
+    const int fd = memfd_create("dump", 0);
+
+    TEST_ASSERT_EQUAL(0, dump_signal(SIGUSR2, fd));
+    raise(SIGUSR2);
+    TEST_ASSERT_TRUE(dump_read(fd, out) > 0);
+    TEST_ASSERT_NOT_NULL(strstr(out, "\"zones\":["));
+    signal(SIGUSR2, SIG_DFL);
+    close(fd);
+}
+
+void test_dump_busy(void) {
+    const int fd = memfd_create("dump", 0);
+    int ret;
+    int saved_errno;
+
+    //Gives up at once instead of waiting for the lock
+    memory_lock();
+    ret = dump_memory(fd);
+    saved_errno = errno;
+    memory_unlock();
+    TEST_ASSERT_EQUAL(-1, ret);
+    TEST_ASSERT_EQUAL(EBUSY, saved_errno);
+    TEST_ASSERT_EQUAL(0, lseek(fd, 0, SEEK_END));
+    close(fd);
+}
+
+void test_dump_signal_busy(void) {
+    const int fd = memfd_create("dump", 0);
+    int saved_errno;
+
+    //The handler fails with EBUSY but must not change the errno it interrupted
+    TEST_ASSERT_EQUAL(0, dump_signal(SIGUSR2, fd));
+    memory_lock();
+    errno = ENOENT;
+    raise(SIGUSR2);
+    saved_errno = errno;
+    memory_unlock();
+    TEST_ASSERT_EQUAL(ENOENT, saved_errno);
+    TEST_ASSERT_EQUAL(0, lseek(fd, 0, SEEK_END));
+    signal(SIGUSR2, SIG_DFL);
+    close(fd);
+}
+
+static size_t dump_read(int fd, char *out) {
+    ssize_t len;
+
+    lseek(fd, 0, SEEK_SET);
+    len = read(fd, out, DUMP_READ_SIZE - 1);
+    TEST_ASSERT_TRUE(len >= 0);
+    out[len] = '\0';
+    return len;
+}
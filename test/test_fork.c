@@ -0,0 +1,111 @@
+#include "unity.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "maintenance.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "config.h"
+#include "stats.h"
+
+#define FORK_COUNT      64
+#define FORK_TIMEOUT    5       // Seconds a child gets before it's killed
+#define FORK_ROUNDS     100
+#define FORK_DECAY_MS   50
+
+void test_fork_busy_heap(void);
+void test_fork_maintenance(void);
+static void *fork_thread_routine(void *arg);
+static int fork_run(void (*child)(void));
+static void fork_child_malloc(void);
+static void fork_child_maintenance(void);
+
+static atomic_bool  running_g = false;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fork_busy_heap);
+    RUN_TEST(test_fork_maintenance);
+
+    return UNITY_END();
+}
+
+void test_fork_busy_heap(void) {
+    pthread_t thread;
+
+    //Forks while another thread keeps taking the lock
+    atomic_store(&running_g, true);
+    TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, fork_thread_routine, NULL));
+    for (size_t i = 0; i < FORK_COUNT; i++) {
+        TEST_ASSERT_EQUAL(0, fork_run(fork_child_malloc));
+    }
+    atomic_store(&running_g, false);
+    TEST_ASSERT_EQUAL(0, pthread_join(thread, NULL));
+}
+
+void test_fork_maintenance(void) {
+    config_g.decay_ms = FORK_DECAY_MS;
+    TEST_ASSERT_TRUE(maintenance_start());
+    TEST_ASSERT_EQUAL(0, fork_run(fork_child_maintenance));
+    maintenance_stop();
+}
+
+static void *fork_thread_routine(void *arg) {
+    (void)arg;
+    while (atomic_load(&running_g)) {
+        free(malloc(SMALL_CHUNK_SIZE));
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run \a child in a forked process, killed if it hangs
+ * @return The exit status of the child, -1 if it didn't exit normally
+ */
+static int fork_run(void (*child)(void)) {
+    const pid_t pid = fork();
+    int status;
+
+    if (pid == 0) {
+        alarm(FORK_TIMEOUT);
+        child();
+        _exit(0);
+    }
+    if (pid == -1 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+static void fork_child_malloc(void) {
+    for (size_t i = 0; i < FORK_ROUNDS; i++) {
+        free(malloc(SMALL_CHUNK_SIZE));
+    }
+}
+
+/**
+ * @brief Exit with 1 if the mapping freed in the child isn't released by the
+ * maintenance thread of the child: the one of the parent wasn't forked
+ */
+static void fork_child_maintenance(void) {
+    stats_t stats;
+
+    free(malloc(MEDIUM_CHUNK_SIZE * 64));
+    for (size_t i = 0; i < FORK_ROUNDS; i++) {
+        stats_get(STATS_LARGE, &stats);
+        if (stats.mapped == 0) {
+            maintenance_stop();
+            return;
+        }
+        usleep(FORK_DECAY_MS * 1000);
+    }
+    _exit(1);
+}
@@ -5,7 +5,7 @@
 #include "chunk.h"
 #include "memory.h"
 
-#define LARGE_CHUNK_SIZE (SMALL_CHUNK_SIZE * 8)
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 2)
 
 void test_free_basic_tiny(void);
 void test_free_basic_small(void);
@@ -73,7 +73,7 @@ void test_free_basic_small(void) {
 }
 
 void test_free_basic_large_next_chunk_freed(void) {
-    const size_t CHUNK_SIZE = SMALL_CHUNK_SIZE * 8;
+    const size_t CHUNK_SIZE = LARGE_CHUNK_SIZE;
     void *addr1, *addr2;
     chunk_t chunk1;
 
@@ -81,21 +81,21 @@ void test_free_basic_large_next_chunk_freed(void) {
     chunk1 = addr1 - CHUNK_METADATA_SIZE;
     TEST_ASSERT_FALSE(chunk1->free);
     addr2 = ft_malloc(CHUNK_SIZE);
-    TEST_ASSERT_NOT_NULL(chunk1->next);
+    TEST_ASSERT_EQUAL(2, memory_g.large.count);
 
-    TEST_ASSERT_EQUAL(chunk1, memory_g.large_head);
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, chunk1));
     free(addr2);
     //Here the chunk should be unmapped
     //TODO: check if munmap was called
-    TEST_ASSERT_NULL(chunk1->next);
+    TEST_ASSERT_NULL(registry_search(&memory_g.large, addr2 - CHUNK_METADATA_SIZE));
     free(addr1);
     //Here the chunk should be unmapped
     //TODO: check if munmap was called
-    TEST_ASSERT_NULL(memory_g.large_head);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
 }
 
 void test_free_basic_large_prev_chunk_freed(void) {
-    const size_t CHUNK_SIZE = SMALL_CHUNK_SIZE * 8;
+    const size_t CHUNK_SIZE = LARGE_CHUNK_SIZE;
     void *addr1, *addr2;
     chunk_t chunk1, chunk2;
 
@@ -103,16 +103,16 @@ void test_free_basic_large_prev_chunk_freed(void) {
     chunk1 = addr1 - CHUNK_METADATA_SIZE;
     addr2 = ft_malloc(CHUNK_SIZE);
     chunk2 = addr2 - CHUNK_METADATA_SIZE;
-    TEST_ASSERT_NOT_NULL(chunk2->prev);
+    TEST_ASSERT_EQUAL(2, memory_g.large.count);
 
-    TEST_ASSERT_EQUAL(chunk1, memory_g.large_head);
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, chunk1));
     free(addr1);
     //Here the chunk should be unmapped
     //TODO: check if munmap was called
-    TEST_ASSERT_NULL(chunk2->prev);
-    TEST_ASSERT_EQUAL(chunk2, memory_g.large_head);
+    TEST_ASSERT_NULL(registry_search(&memory_g.large, chunk1));
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, chunk2));
     free(addr2);
     //Here the chunk should be unmapped
     //TODO: check if munmap was called
-    TEST_ASSERT_NULL(memory_g.large_head);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
 }
@@ -0,0 +1,173 @@
+#include "unity.h"
+
+#include "malloc.h"
+#include "realloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "tree.h"
+#include "quick.h"
+#include "hardening.h"
+#include "memory.h"
+#include "def.h"
+
+#define HARDENING_SIZE  1024    // Above the sizes of the cache
+
+void test_hardening_invalid_pointer(void);
+void test_hardening_size_checksum(void);
+void test_hardening_tree_encoding(void);
+void test_hardening_quick_encoding(void);
+void test_hardening_link_checksum(void);
+void test_hardening_fusion(void);
+static void hardening_flush(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_hardening_invalid_pointer);
+    RUN_TEST(test_hardening_size_checksum);
+    RUN_TEST(test_hardening_tree_encoding);
+    RUN_TEST(test_hardening_quick_encoding);
+    RUN_TEST(test_hardening_link_checksum);
+    RUN_TEST(test_hardening_fusion);
+
+    return UNITY_END();
+}
+
+void test_hardening_invalid_pointer(void) {
+    void *addr = malloc(TINY_CHUNK_SIZE);
+    zone_t zone;
+
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr, &zone, NULL));
+#if HARDENING_CHECK
+    //A pointer inside the data doesn't carry a valid magic
+    TEST_ASSERT_NULL(chunk_validate(addr + ALIGN_SIZE, &zone, NULL));
+#else
+    //The fast build trusts any pointer inside a zone
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr + ALIGN_SIZE, &zone, NULL));
+#endif
+    free(addr);
+}
+
+void test_hardening_size_checksum(void) {
+    void *addr = malloc(TINY_CHUNK_SIZE);
+    chunk_t chunk = addr - CHUNK_METADATA_SIZE;
+    zone_t zone;
+
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+    chunk->size += ALIGN_SIZE;
+#ifdef MALLOC_HARDENING_HARDENED
+    TEST_ASSERT_FALSE(chunk_check(chunk));
+    TEST_ASSERT_NULL(chunk_validate(addr, &zone, NULL));
+#else
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr, &zone, NULL));
+#endif
+    chunk->size -= ALIGN_SIZE;
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+    //The seal must follow the size through split and fusion
+    addr = realloc(addr, ALIGN_SIZE);
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+    addr = realloc(addr, TINY_CHUNK_SIZE);
+    TEST_ASSERT_TRUE(chunk_check(addr - CHUNK_METADATA_SIZE));
+    free(addr);
+}
+
+void test_hardening_tree_encoding(void) {
+    uint8_t buffer[2][CHUNK_METADATA_SIZE + TREE_MIN_SIZE] __attribute__((aligned(16)));
+    chunk_t root = NULL;
+    chunk_t a = (chunk_t)buffer[0];
+    chunk_t b = (chunk_t)buffer[1];
+
+    chunk_init(a, TREE_MIN_SIZE);
+    chunk_init(b, TREE_MIN_SIZE);
+    tree_insert(&root, a);
+    tree_insert(&root, b);
+    TEST_ASSERT_EQUAL_PTR(a, root);
+    TEST_ASSERT_EQUAL_PTR(b, TREE_RIGHT(a));
+    TEST_ASSERT_NULL(TREE_LEFT(a));
+#ifdef MALLOC_HARDENING_HARDENED
+    //The raw values stored in the free chunk are not usable pointers
+    TEST_ASSERT_NOT_EQUAL((uintptr_t)b, (uintptr_t)TREE_NODE(a)->right);
+    TEST_ASSERT_NOT_NULL(TREE_NODE(a)->left);
+#else
+    TEST_ASSERT_EQUAL_PTR(b, TREE_NODE(a)->right);
+#endif
+}
+
+void test_hardening_quick_encoding(void) {
+    uint8_t buffer[2][CHUNK_METADATA_SIZE + QUICK_MIN_SIZE] __attribute__((aligned(16)));
+    chunk_t a = (chunk_t)buffer[0];
+    chunk_t b = (chunk_t)buffer[1];
+    zone_t zone = (zone_t)buffer;
+
+    chunk_init(a, QUICK_MIN_SIZE);
+    QUICK_SET_NEXT(a, b);
+    QUICK_SET_ZONE(a, zone);
+    TEST_ASSERT_EQUAL_PTR(b, QUICK_NEXT(a));
+    TEST_ASSERT_EQUAL_PTR(zone, QUICK_ZONE(a));
+#ifdef MALLOC_HARDENING_HARDENED
+    //The zone free_chunk writes through can't be forged either
+    TEST_ASSERT_NOT_EQUAL((uintptr_t)zone, (uintptr_t)QUICK_LINK(a)->zone);
+#else
+    TEST_ASSERT_EQUAL_PTR(zone, QUICK_LINK(a)->zone);
+#endif
+}
+
+void test_hardening_link_checksum(void) {
+    void *addr = malloc(TINY_CHUNK_SIZE);
+    chunk_t chunk = addr - CHUNK_METADATA_SIZE;
+    chunk_t next = chunk->next;
+
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+    chunk->next = chunk;
+#ifdef MALLOC_HARDENING_HARDENED
+    TEST_ASSERT_FALSE(chunk_check(chunk));
+#else
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+#endif
+    chunk->next = next;
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+    free(addr);
+}
+
+void test_hardening_fusion(void) {
+#ifdef MALLOC_HARDENING_HARDENED
+    void *addr_a = malloc(HARDENING_SIZE);
+    void *addr_b = malloc(HARDENING_SIZE);
+    void *addr_c = malloc(HARDENING_SIZE);
+    chunk_t a = addr_a - CHUNK_METADATA_SIZE;
+    chunk_t b = addr_b - CHUNK_METADATA_SIZE;
+    chunk_t next;
+
+    TEST_ASSERT_EQUAL_PTR(b, a->next);
+    free(addr_b);
+    hardening_flush();
+    TEST_ASSERT_TRUE(b->free);
+    //An overflow of a rewrites the links of the free chunk after it
+    next = b->next;
+    b->next = (chunk_t)addr_c;
+    free(addr_a);
+    hardening_flush();
+    //Its links were not followed, nor merged into a
+    TEST_ASSERT_TRUE(a->free);
+    TEST_ASSERT_EQUAL_PTR(b, a->next);
+    TEST_ASSERT_EQUAL(HARDENING_SIZE, a->size);
+    b->next = next;
+    free(addr_c);
+    hardening_flush();
+#else
+    TEST_IGNORE_MESSAGE("Links are only sealed with MALLOC_HARDENING_HARDENED");
+#endif
+}
+
+/**
+ * @brief Coalesce the chunks kept aside by the quick lists
+ */
+static void hardening_flush(void) {
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+}
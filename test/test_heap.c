@@ -0,0 +1,103 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "heap.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "quick.h"
+#include "stats.h"
+#include "def.h"
+
+void test_heap_isolation(void);
+void test_heap_realloc(void);
+void test_heap_config(void);
+
+static void heap_flush(heap_t heap);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_heap_isolation);
+    RUN_TEST(test_heap_realloc);
+    RUN_TEST(test_heap_config);
+
+    return UNITY_END();
+}
+
+void test_heap_isolation(void) {
+    const size_t sizes[] = {TINY_CHUNK_SIZE, SMALL_CHUNK_SIZE, MEDIUM_CHUNK_SIZE, MEDIUM_CHUNK_SIZE * 64};
+    const size_t main_tick = memory_main_g.tick;
+    heap_t heap = heap_create(NULL);
+    void *addrs[4];
+    zone_t zone;
+
+    TEST_ASSERT_NOT_NULL(heap);
+    for (size_t i = 0; i < 4; i++) {
+        addrs[i] = heap_malloc(heap, sizes[i]);
+        TEST_ASSERT_NOT_NULL(addrs[i]);
+        memset(addrs[i], 0xAB, sizes[i]);
+        //The main heap doesn't know the chunk
+        TEST_ASSERT_NULL(chunk_validate(addrs[i], &zone, NULL));
+    }
+    TEST_ASSERT_EQUAL(main_tick, memory_main_g.tick);
+    TEST_ASSERT_EQUAL(&memory_main_g, &memory_g);
+    TEST_ASSERT_EQUAL(1, heap->memory.stats[STATS_TINY].used_count);
+    TEST_ASSERT_EQUAL(1, heap->memory.stats[STATS_LARGE].used_count);
+    heap_free(heap, addrs[0]);
+    heap_flush(heap);
+    TEST_ASSERT_EQUAL(0, heap->memory.stats[STATS_TINY].used_count);
+    //Everything left is unmapped at once
+    heap_destroy(heap);
+}
+
+void test_heap_realloc(void) {
+    heap_t heap = heap_create(NULL);
+    uint8_t *addr;
+
+    addr = heap_realloc(heap, NULL, 16);
+    memset(addr, 0xAB, 16);
+    addr = heap_realloc(heap, addr, SMALL_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(0xAB, addr[15]);
+    //Grown in place or moved, but only in the heap
+    TEST_ASSERT_EQUAL(1, heap->memory.stats[STATS_TINY].used_count + heap->memory.stats[STATS_SMALL].used_count);
+    heap_free(heap, addr);
+    TEST_ASSERT_EQUAL(0, heap->memory.stats[STATS_TINY].used_count + heap->memory.stats[STATS_SMALL].used_count);
+    heap_destroy(heap);
+}
+
+void test_heap_config(void) {
+    const config_t config = {
+        .large_threshold_min = SMALL_CHUNK_SIZE,
+        .large_threshold_max = SMALL_CHUNK_SIZE,
+        .large_threshold_window = 0,
+    };
+    heap_t heap = heap_create(&config);
+    void *addr;
+
+    //Without medium class, this goes straight to a mapping
+    addr = heap_malloc(heap, SMALL_CHUNK_SIZE * 2);
+    TEST_ASSERT_EQUAL(1, heap->memory.large.count);
+    TEST_ASSERT_NULL(heap->memory.medium_head);
+    heap_free(heap, addr);
+    TEST_ASSERT_EQUAL(SMALL_CHUNK_SIZE, heap->memory.large_threshold);
+    heap_destroy(heap);
+}
+
+/**
+ * @brief Coalesce the quick lists of \a heap, which keep their chunks used.
+ * Locks it the way heap_malloc does.
+ */
+static void heap_flush(heap_t heap) {
+    pthread_mutex_lock(&heap->memory.lock);
+    memory_current_g = &heap->memory;
+    quick_flush(NULL);
+    memory_current_g = &memory_main_g;
+    pthread_mutex_unlock(&heap->memory.lock);
+}
@@ -0,0 +1,79 @@
+#include "unity.h"
+
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "memory.h"
+#include "cache.h"
+#include "quick.h"
+#include "config.h"
+#include "def.h"
+
+#define LARGE_CHUNK_SIZE (CONFIG_LARGE_THRESHOLD_MIN * 2)
+
+void test_large_threshold_short_lived(void);
+void test_large_threshold_long_lived(void);
+void test_large_threshold_max(void);
+
+static void *addrs_g[CONFIG_LARGE_THRESHOLD_WINDOW + 1];
+
+void setUp(void) {
+    config_g.large_threshold_min = CONFIG_LARGE_THRESHOLD_MIN;
+    config_g.large_threshold_max = CONFIG_LARGE_THRESHOLD_MAX;
+    config_g.large_threshold_window = CONFIG_LARGE_THRESHOLD_WINDOW;
+    memory_g.large_threshold = CONFIG_LARGE_THRESHOLD_MIN;
+}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_large_threshold_short_lived);
+    RUN_TEST(test_large_threshold_long_lived);
+    RUN_TEST(test_large_threshold_max);
+
+    return UNITY_END();
+}
+
+void test_large_threshold_short_lived(void) {
+    void *addr = malloc(LARGE_CHUNK_SIZE);
+
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, addr - CHUNK_METADATA_SIZE));
+    free(addr);
+    TEST_ASSERT_EQUAL(LARGE_CHUNK_SIZE, memory_g.large_threshold);
+    //The same size is now served from a medium zone
+    addr = malloc(LARGE_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+    TEST_ASSERT_NOT_NULL(zone_validate((uintptr_t)addr, memory_g.medium_head));
+    free(addr);
+    TEST_ASSERT_EQUAL(LARGE_CHUNK_SIZE, memory_g.large_threshold);
+}
+
+void test_large_threshold_long_lived(void) {
+    void *addr = malloc(LARGE_CHUNK_SIZE);
+
+    //Allocations served by the cache or the quick lists don't advance the
+    //tick, they are all held
+    cache_flush();
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+    for (size_t i = 0; i <= CONFIG_LARGE_THRESHOLD_WINDOW; i++) {
+        addrs_g[i] = malloc(TINY_CHUNK_SIZE);
+    }
+    free(addr);
+    for (size_t i = 0; i <= CONFIG_LARGE_THRESHOLD_WINDOW; i++) {
+        free(addrs_g[i]);
+    }
+    TEST_ASSERT_EQUAL(CONFIG_LARGE_THRESHOLD_MIN, memory_g.large_threshold);
+}
+
+void test_large_threshold_max(void) {
+    void *addr = malloc(CONFIG_LARGE_THRESHOLD_MAX + ALIGN_SIZE);
+
+    free(addr);
+    TEST_ASSERT_EQUAL(CONFIG_LARGE_THRESHOLD_MIN, memory_g.large_threshold);
+    config_g.large_threshold_max = CONFIG_LARGE_THRESHOLD_MIN;
+    free(malloc(LARGE_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(CONFIG_LARGE_THRESHOLD_MIN, memory_g.large_threshold);
+}
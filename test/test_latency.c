@@ -0,0 +1,99 @@
+#include "unity.h"
+
+#include "malloc.h"
+#include "free.h"
+#include "realloc.h"
+#include "chunk.h"
+#include "config.h"
+#include "latency.h"
+#include "stats.h"
+
+#define LATENCY_CALLS   1000
+
+void test_latency_fast(void);
+void test_latency_growth(void);
+void test_latency_syscall(void);
+
+void setUp(void) {
+    latency_enable(true);
+}
+
+void tearDown(void) {
+    latency_enable(false);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_latency_fast);
+    RUN_TEST(test_latency_growth);
+    RUN_TEST(test_latency_syscall);
+
+    return UNITY_END();
+}
+
+void test_latency_fast(void) {
+    stats_latency_t before;
+    stats_latency_t after;
+    void *addr;
+
+#ifndef MALLOC_LATENCY
+    TEST_ASSERT_FALSE(stats_latency(LATENCY_MALLOC, LATENCY_PATH_FAST, &after));
+    TEST_IGNORE_MESSAGE("built without MALLOC_LATENCY");
+#endif
+    //The first call may have to map the zone
+    free(malloc(TINY_CHUNK_SIZE));
+    TEST_ASSERT_TRUE(stats_latency(LATENCY_MALLOC, LATENCY_PATH_FAST, &before));
+    for (size_t i = 0; i < LATENCY_CALLS; i++) {
+        addr = malloc(TINY_CHUNK_SIZE);
+        addr = realloc(addr, TINY_CHUNK_SIZE / 2);
+        free(addr);
+    }
+    stats_latency(LATENCY_MALLOC, LATENCY_PATH_FAST, &after);
+    TEST_ASSERT_GREATER_OR_EQUAL(before.count + LATENCY_CALLS, after.count);
+    TEST_ASSERT_LESS_OR_EQUAL(after.p99, after.p50);
+    TEST_ASSERT_LESS_OR_EQUAL(after.p999, after.p99);
+    TEST_ASSERT_LESS_OR_EQUAL(after.max, after.p999);
+    stats_latency(LATENCY_FREE, LATENCY_PATH_FAST, &after);
+    TEST_ASSERT_GREATER_OR_EQUAL(LATENCY_CALLS, after.count);
+    stats_latency(LATENCY_REALLOC, LATENCY_PATH_FAST, &after);
+    TEST_ASSERT_GREATER_OR_EQUAL(LATENCY_CALLS, after.count);
+}
+
+void test_latency_growth(void) {
+    void *addrs[CHUNK_PER_ZONE * 2];
+    stats_latency_t before;
+    stats_latency_t after;
+
+#ifndef MALLOC_LATENCY
+    TEST_IGNORE_MESSAGE("built without MALLOC_LATENCY");
+#endif
+    stats_latency(LATENCY_MALLOC, LATENCY_PATH_GROWTH, &before);
+    //Two zones worth of chunks need at least one more zone
+    for (size_t i = 0; i < CHUNK_PER_ZONE * 2; i++) {
+        addrs[i] = malloc(SMALL_CHUNK_SIZE);
+    }
+    stats_latency(LATENCY_MALLOC, LATENCY_PATH_GROWTH, &after);
+    TEST_ASSERT_GREATER_THAN(before.count, after.count);
+    TEST_ASSERT_GREATER_THAN(0, after.max);
+    for (size_t i = 0; i < CHUNK_PER_ZONE * 2; i++) {
+        free(addrs[i]);
+    }
+}
+
+void test_latency_syscall(void) {
+    stats_latency_t malloc_before;
+    stats_latency_t free_before;
+    stats_latency_t after;
+
+#ifndef MALLOC_LATENCY
+    TEST_IGNORE_MESSAGE("built without MALLOC_LATENCY");
+#endif
+    stats_latency(LATENCY_MALLOC, LATENCY_PATH_SYSCALL, &malloc_before);
+    stats_latency(LATENCY_FREE, LATENCY_PATH_SYSCALL, &free_before);
+    free(malloc(CONFIG_LARGE_THRESHOLD_MAX * 2));
+    stats_latency(LATENCY_MALLOC, LATENCY_PATH_SYSCALL, &after);
+    TEST_ASSERT_EQUAL(malloc_before.count + 1, after.count);
+    stats_latency(LATENCY_FREE, LATENCY_PATH_SYSCALL, &after);
+    TEST_ASSERT_EQUAL(free_before.count + 1, after.count);
+}
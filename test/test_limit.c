@@ -0,0 +1,109 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "limit.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "config.h"
+#include "stats.h"
+
+// Above the highest zone/mmap threshold, so that each allocation is a mapping
+#define LIMIT_SIZE      (CONFIG_LARGE_THRESHOLD_MAX * 2)
+#define LIMIT_MARGIN    (LIMIT_SIZE / 2)
+
+void test_limit_fail(void);
+void test_limit_callback(void);
+void test_limit_pressure(void);
+
+static size_t   limit_mapped(void);
+static void     limit_count(size_t size);
+static void     limit_release(size_t size);
+
+static size_t   callback_count;
+static void     *held;
+
+void setUp(void) {
+    callback_count = 0;
+    config_g.limit = 0;
+}
+
+void tearDown(void) {
+    limit_set_callback(NULL);
+    config_g.limit = 0;
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_limit_fail);
+    RUN_TEST(test_limit_callback);
+    RUN_TEST(test_limit_pressure);
+
+    return UNITY_END();
+}
+
+void test_limit_fail(void) {
+    limit_set_callback(limit_count);
+    config_g.limit = limit_mapped() + LIMIT_MARGIN;
+    TEST_ASSERT_NULL(malloc(LIMIT_SIZE));
+    //The callback runs once, before the last try
+    TEST_ASSERT_EQUAL(1, callback_count);
+    config_g.limit = 0;
+    free(malloc(LIMIT_SIZE));
+}
+
+void test_limit_callback(void) {
+    void *addr;
+
+    held = malloc(LIMIT_SIZE);
+    memset(held, 0xAB, LIMIT_SIZE);
+    limit_set_callback(limit_release);
+    config_g.limit = limit_mapped() + LIMIT_MARGIN;
+    //Only fits once the callback freed the held memory
+    addr = malloc(LIMIT_SIZE);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_NULL(held);
+    free(addr);
+}
+
+void test_limit_pressure(void) {
+    void *addrs[CHUNK_PER_ZONE * 2];
+    size_t empty_count = 0;
+
+    for (size_t i = 0; i < CHUNK_PER_ZONE * 2; i++) {
+        addrs[i] = malloc(SMALL_CHUNK_SIZE);
+    }
+    //Always close to the limit
+    config_g.limit = 1;
+    for (size_t i = 0; i < CHUNK_PER_ZONE * 2; i++) {
+        free(addrs[i]);
+    }
+    for (zone_t zone = memory_g.small_head; zone; zone = zone->next) {
+        empty_count += zone_empty(zone);
+    }
+    TEST_ASSERT_EQUAL(0, empty_count);
+}
+
+static size_t limit_mapped(void) {
+    size_t mapped;
+
+    memory_lock();
+    mapped = stats_mapped();
+    memory_unlock();
+    return mapped;
+}
+
+static void limit_count(size_t size) {
+    TEST_ASSERT_GREATER_OR_EQUAL(LIMIT_SIZE, size);
+    callback_count++;
+}
+
+static void limit_release(size_t size) {
+    (void)size;
+    free(held);
+    held = NULL;
+}
@@ -0,0 +1,151 @@
+#include "unity.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "maintenance.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "quick.h"
+#include "stats.h"
+#include "config.h"
+#include "def.h"
+#include "tree.h"
+
+#define MAINTENANCE_PURGE_CHUNKS    16
+
+void test_maintenance_large_reuse(void);
+void test_maintenance_large_limit(void);
+void test_maintenance_zone_decay(void);
+void test_maintenance_zone_purge(void);
+
+static size_t maintenance_empty_count(zone_t zone);
+
+void setUp(void) {
+    //The thread never wakes up by itself, passes are run by the tests
+    config_g.decay_ms = 3600 * 1000;
+    TEST_ASSERT_TRUE(maintenance_start());
+}
+
+void tearDown(void) {
+    maintenance_stop();
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_maintenance_large_reuse);
+    RUN_TEST(test_maintenance_large_limit);
+    RUN_TEST(test_maintenance_zone_decay);
+    RUN_TEST(test_maintenance_zone_purge);
+
+    return UNITY_END();
+}
+
+void test_maintenance_large_reuse(void) {
+    const size_t size = MEDIUM_CHUNK_SIZE * 64;
+    void *addr;
+
+    addr = malloc(size);
+    memset(addr, 0xAB, size);
+    free(addr);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+    //The mapping wasn't unmapped yet, so it's reused
+    TEST_ASSERT_EQUAL(addr, malloc(size - ALIGN_SIZE));
+    free(addr);
+    maintenance_run(true);
+    addr = malloc(size);
+    memset(addr, 0xAB, size);
+    free(addr);
+}
+
+void test_maintenance_large_limit(void) {
+    const size_t size = MEDIUM_CHUNK_SIZE * 64;
+    const size_t zone_count = memory_g.stats[STATS_LARGE].zone_count;
+    void *addr = malloc(size);
+    size_t mapped;
+
+    TEST_ASSERT_NOT_NULL(addr);
+    mapped = stats_mapped();
+    free(addr);
+    //Counted until it's unmapped
+    TEST_ASSERT_EQUAL(mapped, stats_mapped());
+    TEST_ASSERT_EQUAL(zone_count + 1, memory_g.stats[STATS_LARGE].zone_count);
+    //Taking it back is a new mapping for the limit
+    config_g.limit = mapped - 1;
+    TEST_ASSERT_NULL(malloc(size));
+    config_g.limit = 0;
+    //Unmapped by the reclaim
+    TEST_ASSERT_EQUAL(zone_count, memory_g.stats[STATS_LARGE].zone_count);
+    TEST_ASSERT_LESS_THAN(mapped, stats_mapped());
+}
+
+void test_maintenance_zone_decay(void) {
+    void *addrs[CHUNK_PER_ZONE * 2];
+
+    for (size_t i = 0; i < CHUNK_PER_ZONE * 2; i++) {
+        addrs[i] = malloc(SMALL_CHUNK_SIZE);
+    }
+    for (size_t i = 0; i < CHUNK_PER_ZONE * 2; i++) {
+        free(addrs[i]);
+    }
+    //The quick lists keep their chunks used until a pass flushes them
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+    //Every zone stays mapped until it decays
+    TEST_ASSERT_GREATER_OR_EQUAL(2, maintenance_empty_count(memory_g.small_head));
+    maintenance_run(false);
+    TEST_ASSERT_GREATER_OR_EQUAL(2, maintenance_empty_count(memory_g.small_head));
+    //Only one empty zone is kept, purged
+    maintenance_run(true);
+    TEST_ASSERT_EQUAL(1, maintenance_empty_count(memory_g.small_head));
+}
+
+void test_maintenance_zone_purge(void) {
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    void *addrs[MAINTENANCE_PURGE_CHUNKS];
+    unsigned char pages[MAINTENANCE_PURGE_CHUNKS * SMALL_CHUNK_SIZE / 4096 + 2];
+    chunk_t chunk;
+    uintptr_t start;
+    uintptr_t end;
+
+    for (size_t i = 0; i < MAINTENANCE_PURGE_CHUNKS; i++) {
+        addrs[i] = malloc(SMALL_CHUNK_SIZE);
+        memset(addrs[i], 0xAB, SMALL_CHUNK_SIZE);
+    }
+    for (size_t i = 1; i < MAINTENANCE_PURGE_CHUNKS; i++) {
+        TEST_ASSERT_EQUAL_PTR((char*)addrs[i - 1] + SMALL_CHUNK_SIZE + CHUNK_METADATA_SIZE, addrs[i]);
+    }
+    //The zone stays used by the first and the last chunk
+    for (size_t i = 1; i < MAINTENANCE_PURGE_CHUNKS - 1; i++) {
+        free(addrs[i]);
+    }
+    maintenance_run(true);
+    chunk = (chunk_t)((char*)addrs[1] - CHUNK_METADATA_SIZE);
+    TEST_ASSERT_TRUE(chunk->free);
+    start = ((uintptr_t)chunk->data + TREE_MIN_SIZE + page_size - 1) & ~(page_size - 1);
+    end = ((uintptr_t)chunk->data + chunk->size) & ~(page_size - 1);
+    TEST_ASSERT_GREATER_THAN(start, end);
+    TEST_ASSERT_EQUAL(0, mincore((void*)(start - page_size), end - start + page_size, pages));
+    //The header page is kept, the ones after it are given back
+    TEST_ASSERT_EQUAL(1, pages[0] & 1);
+    for (size_t i = 1; i <= (end - start) / page_size; i++) {
+        TEST_ASSERT_EQUAL(0, pages[i] & 1);
+    }
+    free(addrs[0]);
+    free(addrs[MAINTENANCE_PURGE_CHUNKS - 1]);
+}
+
+static size_t maintenance_empty_count(zone_t zone) {
+    size_t count = 0;
+
+    for (; zone; zone = zone->next) {
+        count += zone_empty(zone);
+    }
+    return count;
+}
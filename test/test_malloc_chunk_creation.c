@@ -3,8 +3,9 @@
 
 #include "malloc.h"
 #include "chunk.h"
+#include "memory.h"
 
-#define LARGE_CHUNK_SIZE (SMALL_CHUNK_SIZE * 8)
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 2)
 
 static void test_malloc_chunk_creation_tiny(void);
 static void test_malloc_chunk_creation_small(void);
@@ -82,6 +83,7 @@ static void test_malloc_chunk_creation_large(void) {
     chunk_t chunk2 = addr2 - CHUNK_METADATA_SIZE;
     TEST_ASSERT_EQUAL(LARGE_CHUNK_SIZE, chunk2->size);
     TEST_ASSERT_NULL(chunk2->next);
-    TEST_ASSERT_EQUAL(chunk1, chunk2->prev);
-    TEST_ASSERT_EQUAL(chunk2, chunk1->next);
+    TEST_ASSERT_NULL(chunk2->prev);
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, chunk1));
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, chunk2));
 }
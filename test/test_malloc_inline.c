@@ -0,0 +1,90 @@
+#include "unity.h"
+
+#include "malloc_inline.h"
+#include "free.h"
+#include "memory.h"
+#include "def.h"
+
+struct malloc_inline_tiny_s {
+    void    *ptr[3];
+};
+
+struct malloc_inline_small_s {
+    char    data[1000];
+};
+
+void test_malloc_inline_tiny(void);
+void test_malloc_inline_small(void);
+void test_malloc_inline_runtime_size(void);
+void test_malloc_inline_runtime_class(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_malloc_inline_tiny);
+    RUN_TEST(test_malloc_inline_small);
+    RUN_TEST(test_malloc_inline_runtime_size);
+    RUN_TEST(test_malloc_inline_runtime_class);
+
+    return UNITY_END();
+}
+
+void test_malloc_inline_tiny(void) {
+    void *addr = malloc_inline(sizeof(struct malloc_inline_tiny_s));
+    zone_t zone;
+    zone_t *zone_head;
+    chunk_t chunk;
+
+    TEST_ASSERT_NOT_NULL(addr);
+    chunk = chunk_validate(addr, &zone, &zone_head);
+    TEST_ASSERT_NOT_NULL(chunk);
+    TEST_ASSERT_EQUAL_PTR(&memory_g.tiny_head, zone_head);
+    TEST_ASSERT_EQUAL(ALIGN_MEM(sizeof(struct malloc_inline_tiny_s)), chunk->size);
+    free(addr);
+}
+
+void test_malloc_inline_small(void) {
+    void *addr = malloc_inline(sizeof(struct malloc_inline_small_s));
+    zone_t zone;
+    zone_t *zone_head;
+
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr, &zone, &zone_head));
+    TEST_ASSERT_EQUAL_PTR(&memory_g.small_head, zone_head);
+    free(addr);
+}
+
+void test_malloc_inline_runtime_size(void) {
+    volatile size_t size = MEDIUM_CHUNK_SIZE;
+    void *addr = malloc_inline(size);
+    zone_t zone;
+    zone_t *zone_head;
+
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr, &zone, &zone_head));
+    TEST_ASSERT_EQUAL_PTR(&memory_g.medium_head, zone_head);
+    free(addr);
+}
+
+void test_malloc_inline_runtime_class(void) {
+    const size_t small_max = memory_g.small_max;
+    zone_t zone;
+    zone_t *zone_head;
+    void *addr;
+
+    //A tuned small boundary below the compile-time one
+    memory_lock();
+    memory_g.small_max = SMALL_CHUNK_SIZE / 4;
+    memory_unlock();
+    addr = malloc_small(sizeof(struct malloc_inline_small_s) * 2);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_NOT_NULL(chunk_validate(addr, &zone, &zone_head));
+    TEST_ASSERT_EQUAL_PTR(&memory_g.medium_head, zone_head);
+    free(addr);
+    memory_lock();
+    memory_g.small_max = small_max;
+    memory_unlock();
+}
@@ -6,7 +6,7 @@
 #include "zone.h"
 #include "chunk.h"
 
-#define LARGE_CHUNK_SIZE (SMALL_CHUNK_SIZE * 8)
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 2)
 
 static void test_malloc_zone_creation_tiny(void);
 static void test_malloc_zone_creation_large(void);
@@ -0,0 +1,89 @@
+#include "unity.h"
+
+#include <unistd.h>
+
+#include "malloc.h"
+#include "realloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "def.h"
+
+void test_medium_zone(void);
+void test_medium_page_granular(void);
+void test_medium_fusion(void);
+void test_medium_large_limit(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_medium_zone);
+    RUN_TEST(test_medium_page_granular);
+    RUN_TEST(test_medium_fusion);
+    RUN_TEST(test_medium_large_limit);
+
+    return UNITY_END();
+}
+
+void test_medium_zone(void) {
+    void *addr_1 = malloc(SMALL_CHUNK_SIZE + 1);
+    void *addr_2 = malloc(MEDIUM_CHUNK_SIZE);
+
+    TEST_ASSERT_NOT_NULL(memory_g.medium_head);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+    TEST_ASSERT_EQUAL(memory_g.medium_head, zone_validate((uintptr_t)addr_1, memory_g.medium_head));
+    TEST_ASSERT_EQUAL(memory_g.medium_head, zone_validate((uintptr_t)addr_2, memory_g.medium_head));
+    //Both chunks fit in the same zone
+    TEST_ASSERT_GREATER_OR_EQUAL(MEDIUM_CHUNK_SIZE * MEDIUM_CHUNK_PER_ZONE, memory_g.medium_head->size);
+    free(addr_1);
+    free(addr_2);
+}
+
+void test_medium_page_granular(void) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    chunk_t chunk;
+    void *addr;
+
+    for (size_t size = SMALL_CHUNK_SIZE + ALIGN_SIZE; size <= 64 * 1024; size += 1000) {
+        addr = malloc(size);
+        chunk = addr - CHUNK_METADATA_SIZE;
+        TEST_ASSERT_GREATER_OR_EQUAL(size, chunk->size);
+        TEST_ASSERT_EQUAL(0, (chunk->size + CHUNK_METADATA_SIZE) % page_size);
+        TEST_ASSERT_LESS_THAN(size + page_size, chunk->size);
+        free(addr);
+    }
+    TEST_ASSERT_EQUAL(SMALL_CHUNK_SIZE, chunk_round_size(SMALL_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(MEDIUM_CHUNK_SIZE * 2, chunk_round_size(MEDIUM_CHUNK_SIZE * 2));
+}
+
+void test_medium_fusion(void) {
+    void *addr_1 = malloc(8 * 1024);
+    void *addr_2 = malloc(16 * 1024);
+    void *addr_3 = malloc(32 * 1024);
+    chunk_t chunk_1 = addr_1 - CHUNK_METADATA_SIZE;
+    chunk_t chunk_3 = addr_3 - CHUNK_METADATA_SIZE;
+
+    free(addr_2);
+    free(addr_1);
+    TEST_ASSERT_TRUE(chunk_1->free);
+    TEST_ASSERT_EQUAL(chunk_3, chunk_1->next);
+    //The coalesced chunk is reused for a bigger request without a new mapping
+    TEST_ASSERT_EQUAL(addr_1, malloc(20 * 1024));
+    TEST_ASSERT_NULL(memory_g.medium_head->next);
+    free(addr_1);
+    free(addr_3);
+}
+
+void test_medium_large_limit(void) {
+    void *addr = malloc(MEDIUM_CHUNK_SIZE + 1);
+
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, addr - CHUNK_METADATA_SIZE));
+    addr = realloc(addr, MEDIUM_CHUNK_SIZE / 2);
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+    TEST_ASSERT_NOT_NULL(zone_validate((uintptr_t)addr, memory_g.medium_head));
+    free(addr);
+}
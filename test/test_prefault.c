@@ -0,0 +1,120 @@
+#include "unity.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "maintenance.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "config.h"
+#include "stats.h"
+
+// Above the highest zone/mmap threshold, so that the allocation is a mapping
+#define PREFAULT_LARGE_SIZE (CONFIG_LARGE_THRESHOLD_MAX * 2)
+#define PREFAULT_WAIT_MS    2000
+
+void test_prefault_zone(void);
+void test_prefault_large(void);
+void test_pregrow(void);
+
+static bool prefault_resident(void *addr, size_t size);
+
+void setUp(void) {
+    config_g.prefault = 0;
+    config_g.prefault_large_max = 0;
+    config_g.pregrow = 0;
+}
+
+void tearDown(void) {
+    maintenance_stop();
+    config_g.prefault = 0;
+    config_g.prefault_large_max = 0;
+    config_g.pregrow = 0;
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_prefault_zone);
+    RUN_TEST(test_prefault_large);
+    RUN_TEST(test_pregrow);
+
+    return UNITY_END();
+}
+
+void test_prefault_zone(void) {
+    const size_t size = zone_mapping_size(SMALL_CHUNK_SIZE);
+    zone_t zone;
+
+    zone = zone_map(size);
+    TEST_ASSERT_NOT_NULL(zone);
+    //Only the headers were written
+    TEST_ASSERT_FALSE(prefault_resident(zone, size));
+    munmap(zone, size);
+    config_g.prefault = 1;
+    zone = zone_map(size);
+    TEST_ASSERT_NOT_NULL(zone);
+    TEST_ASSERT_TRUE(prefault_resident(zone, size));
+    TEST_ASSERT_EQUAL(size - ZONE_METADATA_SIZE, zone->free_size);
+    munmap(zone, size);
+}
+
+void test_prefault_large(void) {
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    void *addr;
+
+    config_g.prefault = 1;
+    //Above the cap, large mappings are left alone
+    addr = malloc(PREFAULT_LARGE_SIZE);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_FALSE(prefault_resident((void*)((uintptr_t)addr & ~(page_size - 1)), PREFAULT_LARGE_SIZE));
+    free(addr);
+    config_g.prefault_large_max = PREFAULT_LARGE_SIZE;
+    addr = malloc(PREFAULT_LARGE_SIZE);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_TRUE(prefault_resident((void*)((uintptr_t)addr & ~(page_size - 1)), PREFAULT_LARGE_SIZE));
+    free(addr);
+}
+
+void test_pregrow(void) {
+    const size_t zone_size = zone_mapping_size(SMALL_CHUNK_SIZE);
+    stats_t stats;
+    size_t zone_count;
+
+    config_g.pregrow = 1;
+    TEST_ASSERT_TRUE(maintenance_start());
+    TEST_ASSERT_NOT_NULL(malloc(SMALL_CHUNK_SIZE));
+    stats_get(STATS_SMALL, &stats);
+    zone_count = stats.zone_count;
+    //Drain the small class until it runs low, without making it map a zone.
+    //The thread may already have grown it when the loop sees it.
+    while (stats.free_size >= zone_size / MAINTENANCE_PREGROW_RATIO && stats.zone_count == zone_count) {
+        TEST_ASSERT_NOT_NULL(malloc(SMALL_CHUNK_SIZE));
+        stats_get(STATS_SMALL, &stats);
+    }
+    //The thread maps the next zone by itself
+    for (size_t i = 0; i < PREFAULT_WAIT_MS && stats.zone_count == zone_count; i++) {
+        usleep(1000);
+        stats_get(STATS_SMALL, &stats);
+    }
+    TEST_ASSERT_EQUAL(zone_count + 1, stats.zone_count);
+    TEST_ASSERT_GREATER_OR_EQUAL(zone_size / MAINTENANCE_PREGROW_RATIO, stats.free_size);
+}
+
+static bool prefault_resident(void *addr, size_t size) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    unsigned char pages[size / page_size + 1];
+
+    TEST_ASSERT_EQUAL(0, mincore(addr, size, pages));
+    for (size_t i = 0; i < (size + page_size - 1) / page_size; i++) {
+        if (!(pages[i] & 1)) {
+            return false;
+        }
+    }
+    return true;
+}
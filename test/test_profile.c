@@ -0,0 +1,135 @@
+#include "unity.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "profile.h"
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "stats.h"
+#include "def.h"
+
+#define PROFILE_ZONES   3
+#define PROFILE_CHUNKS  256
+
+void test_profile_save_load(void);
+void test_profile_load_invalid(void);
+void test_profile_prewarm(void);
+void test_profile_reserve_decay(void);
+
+static char path_g[64];
+static void *addrs_g[PROFILE_CHUNKS];
+
+void setUp(void) {
+    snprintf(path_g, sizeof(path_g), "/tmp/malloc_profile_%d", getpid());
+}
+
+void tearDown(void) {
+    unlink(path_g);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_profile_save_load);
+    RUN_TEST(test_profile_load_invalid);
+    RUN_TEST(test_profile_prewarm);
+    RUN_TEST(test_profile_reserve_decay);
+
+    return UNITY_END();
+}
+
+void test_profile_save_load(void) {
+    void *addr = malloc(SMALL_CHUNK_SIZE);
+    const stats_t *stats;
+    profile_t profile;
+
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_EQUAL(0, profile_save(path_g));
+    TEST_ASSERT_TRUE(profile_load(path_g, &profile));
+    for (stats_class_t class = STATS_TINY; class < STATS_LARGE; class++) {
+        stats = &memory_g.stats[class];
+        if (stats->peak_used == 0) {
+            TEST_ASSERT_EQUAL(0, profile.zone_count[class]);
+            continue;
+        }
+        TEST_ASSERT_EQUAL(stats->peak_zone_count, profile.zone_count[class]);
+        TEST_ASSERT_LESS_OR_EQUAL(stats->peak_mapped, profile.mapped[class]);
+        TEST_ASSERT_GREATER_OR_EQUAL(stats->peak_used, profile.mapped[class]);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(1, profile.zone_count[STATS_SMALL]);
+    TEST_ASSERT_EQUAL(0, profile.zone_count[STATS_LARGE]);
+    free(addr);
+}
+
+void test_profile_load_invalid(void) {
+    const char content[] = "# nothing\nhuge 1\nsmall 99999999 1\n";
+    profile_t profile;
+    int fd;
+
+    TEST_ASSERT_FALSE(profile_load(path_g, &profile));
+    fd = open(path_g, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    TEST_ASSERT_NOT_EQUAL(-1, fd);
+    TEST_ASSERT_EQUAL(sizeof(content) - 1, write(fd, content, sizeof(content) - 1));
+    close(fd);
+    TEST_ASSERT_FALSE(profile_load(path_g, &profile));
+}
+
+void test_profile_prewarm(void) {
+    const size_t zone_size = zone_mapping_size(SMALL_CHUNK_SIZE + ALIGN_SIZE);
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    profile_t profile = {0};
+    profile_t saved;
+    unsigned char pages[zone_size / page_size + 1];
+    void *addr;
+
+    profile.zone_count[STATS_MEDIUM] = PROFILE_ZONES;
+    profile.mapped[STATS_MEDIUM] = zone_size * PROFILE_ZONES;
+    TEST_ASSERT_EQUAL(0, memory_g.stats[STATS_MEDIUM].zone_count);
+    TEST_ASSERT_EQUAL(zone_size * PROFILE_ZONES, profile_prewarm(&profile));
+    TEST_ASSERT_EQUAL(PROFILE_ZONES, memory_g.stats[STATS_MEDIUM].zone_count);
+    //Prewarmed zones nothing used are not saved back
+    TEST_ASSERT_EQUAL(0, profile_save(path_g));
+    TEST_ASSERT_TRUE(profile_load(path_g, &saved));
+    TEST_ASSERT_EQUAL(0, saved.zone_count[STATS_MEDIUM]);
+    TEST_ASSERT_EQUAL(0, saved.mapped[STATS_MEDIUM]);
+    //Faulted in up front
+    TEST_ASSERT_EQUAL(0, mincore(memory_g.medium_head, zone_size, pages));
+    for (size_t i = 0; i < zone_size / page_size; i++) {
+        TEST_ASSERT_TRUE(pages[i] & 1);
+    }
+    //Served without a new zone, and the empty zones are kept
+    addr = malloc(SMALL_CHUNK_SIZE + ALIGN_SIZE);
+    TEST_ASSERT_NOT_NULL(addr);
+    TEST_ASSERT_EQUAL(PROFILE_ZONES, memory_g.stats[STATS_MEDIUM].zone_count);
+    free(addr);
+    TEST_ASSERT_EQUAL(PROFILE_ZONES, memory_g.stats[STATS_MEDIUM].zone_count);
+    //Nothing above the peak
+    TEST_ASSERT_EQUAL(0, profile_prewarm(&profile));
+}
+
+void test_profile_reserve_decay(void) {
+    const stats_t *stats = &memory_g.stats[STATS_MEDIUM];
+    size_t count = 0;
+
+    //Reach the reserved bytes, the peak the reserve was kept for
+    TEST_ASSERT_NOT_EQUAL(0, memory_g.reserved[STATS_MEDIUM]);
+    while (stats->peak_used + stats->zone_count * ZONE_METADATA_SIZE < memory_g.reserved[STATS_MEDIUM]) {
+        TEST_ASSERT_LESS_THAN(PROFILE_CHUNKS, count);
+        addrs_g[count] = malloc(MEDIUM_CHUNK_SIZE);
+        TEST_ASSERT_NOT_NULL(addrs_g[count]);
+        count++;
+    }
+    for (size_t i = 0; i < count; i++) {
+        free(addrs_g[i]);
+    }
+    //The reserve is dropped, only the one empty zone is kept
+    TEST_ASSERT_EQUAL(0, memory_g.reserved[STATS_MEDIUM]);
+    TEST_ASSERT_EQUAL(1, stats->zone_count);
+}
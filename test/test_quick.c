@@ -0,0 +1,120 @@
+#include "unity.h"
+
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "memory.h"
+#include "cache.h"
+#include "quick.h"
+
+#define QUICK_SIZE  (TINY_CHUNK_SIZE * 2)    // Above the tiny cache
+
+void test_quick_reuse(void);
+void test_quick_threshold(void);
+void test_quick_flush(void);
+void test_quick_double_free(void);
+
+void setUp(void) {
+    cache_flush();
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_quick_reuse);
+    RUN_TEST(test_quick_threshold);
+    RUN_TEST(test_quick_flush);
+    RUN_TEST(test_quick_double_free);
+
+    return UNITY_END();
+}
+
+void test_quick_reuse(void) {
+    void *addr_1;
+    void *addr_2;
+    chunk_t chunk_1;
+    chunk_t chunk_2;
+
+#ifndef MALLOC_QUICK_LIST
+    TEST_IGNORE_MESSAGE("built without MALLOC_QUICK_LIST");
+#endif
+    addr_1 = malloc(QUICK_SIZE);
+    addr_2 = malloc(QUICK_SIZE);
+    chunk_1 = addr_1 - CHUNK_METADATA_SIZE;
+    chunk_2 = addr_2 - CHUNK_METADATA_SIZE;
+    free(addr_1);
+    free(addr_2);
+    //Neither marked free nor merged
+    TEST_ASSERT_FALSE(chunk_1->free);
+    TEST_ASSERT_FALSE(chunk_2->free);
+    TEST_ASSERT_EQUAL(QUICK_SIZE, chunk_1->size);
+    TEST_ASSERT_EQUAL(2, memory_g.quick.counts[QUICK_INDEX(QUICK_SIZE)]);
+    TEST_ASSERT_EQUAL(addr_2, malloc(QUICK_SIZE));
+    TEST_ASSERT_EQUAL(addr_1, malloc(QUICK_SIZE));
+    TEST_ASSERT_EQUAL(0, memory_g.quick.counts[QUICK_INDEX(QUICK_SIZE)]);
+    free(addr_1);
+    free(addr_2);
+}
+
+void test_quick_threshold(void) {
+    void *addrs[QUICK_LIST_MAX + 1];
+
+#ifndef MALLOC_QUICK_LIST
+    TEST_IGNORE_MESSAGE("built without MALLOC_QUICK_LIST");
+#endif
+    for (size_t i = 0; i < QUICK_LIST_MAX + 1; i++) {
+        addrs[i] = malloc(SMALL_CHUNK_SIZE / 2);
+    }
+    for (size_t i = 0; i < QUICK_LIST_MAX; i++) {
+        free(addrs[i]);
+    }
+    TEST_ASSERT_FALSE(((chunk_t)(addrs[0] - CHUNK_METADATA_SIZE))->free);
+    //One more and the whole list is coalesced
+    free(addrs[QUICK_LIST_MAX]);
+    TEST_ASSERT_EQUAL(0, memory_g.quick.counts[QUICK_INDEX(SMALL_CHUNK_SIZE / 2)]);
+    TEST_ASSERT_NULL(memory_g.quick.heads[QUICK_INDEX(SMALL_CHUNK_SIZE / 2)]);
+    TEST_ASSERT_TRUE(((chunk_t)(addrs[QUICK_LIST_MAX] - CHUNK_METADATA_SIZE))->free);
+}
+
+void test_quick_flush(void) {
+    void *addr;
+    chunk_t chunk;
+    bool flushed;
+    bool flushed_again;
+
+#ifndef MALLOC_QUICK_LIST
+    TEST_IGNORE_MESSAGE("built without MALLOC_QUICK_LIST");
+#endif
+    addr = malloc(QUICK_SIZE);
+    chunk = addr - CHUNK_METADATA_SIZE;
+    free(addr);
+    TEST_ASSERT_FALSE(chunk->free);
+    //Asserting with the lock held would leave it held for the next tests
+    memory_lock();
+    flushed = quick_flush(&memory_g.small_head);
+    flushed_again = quick_flush(NULL);
+    memory_unlock();
+    TEST_ASSERT_TRUE(flushed);
+    TEST_ASSERT_FALSE(flushed_again);
+    TEST_ASSERT_NULL(memory_g.quick.heads[QUICK_INDEX(QUICK_SIZE)]);
+}
+
+void test_quick_double_free(void) {
+    void *addr;
+
+#ifndef MALLOC_QUICK_LIST
+    TEST_IGNORE_MESSAGE("built without MALLOC_QUICK_LIST");
+#endif
+    addr = malloc(QUICK_SIZE);
+    free(addr);
+    free(addr);
+#ifndef MALLOC_HARDENING_FAST
+    //The second free is reported instead of linking the chunk twice
+    TEST_ASSERT_EQUAL(1, memory_g.quick.counts[QUICK_INDEX(QUICK_SIZE)]);
+#endif
+}
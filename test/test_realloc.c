@@ -1,4 +1,5 @@
 #include <string.h>
+#include <unistd.h>
 
 #include "unity.h"
 
@@ -7,15 +8,28 @@
 #include "def.h"
 #include "free.h"
 #include "memory.h"
+#include "cache.h"
+#include "quick.h"
+#include "config.h"
+#include "malloc.h"
 
-#define LARGE_CHUNK_SIZE (SMALL_CHUNK_SIZE * 8)
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 4)
 
-void setUp(void) {}
+void realloc_flush(void);
+
+void setUp(void) {
+    //Keep LARGE_CHUNK_SIZE out of the zones, whatever the previous tests freed
+    config_g.large_threshold_max = config_g.large_threshold_min;
+    memory_g.large_threshold = config_g.large_threshold_min;
+    realloc_flush();
+}
 void tearDown(void) {}
 
 void test_realloc_tiny_smaller_new_size(void);
 void test_realloc_small_smaller_new_size(void);
 void test_realloc_large_new_size(void);
+void test_realloc_large_grow_in_place(void);
+void test_realloc_large_to_tiny(void);
 void test_realloc_tiny_bigger_new_size_contiguous_no_gap();
 void test_realloc_tiny_bigger_new_size_contiguous_with_gap();
 void test_realloc_small_bigger_new_size_contiguous_no_gap();
@@ -39,6 +53,8 @@ int main(void) {
     RUN_TEST(test_realloc_tiny_smaller_new_size);
     RUN_TEST(test_realloc_small_smaller_new_size);
     RUN_TEST(test_realloc_large_new_size);
+    RUN_TEST(test_realloc_large_grow_in_place);
+    RUN_TEST(test_realloc_large_to_tiny);
     RUN_TEST(test_realloc_tiny_bigger_new_size_contiguous_no_gap);
     RUN_TEST(test_realloc_small_bigger_new_size_contiguous_no_gap);
     RUN_TEST(test_realloc_tiny_bigger_new_size_contiguous_with_gap);
@@ -67,9 +83,49 @@ void test_realloc_large_new_size() {
     void *addr_2 = realloc(addr_1, LARGE_CHUNK_SIZE / 2);
     chunk_t chunk_2 = addr_2 - CHUNK_METADATA_SIZE;
     realloc_fill_chunk_test(chunk_2, chunk_2->size);
-    TEST_ASSERT_NOT_EQUAL(addr_1, addr_2);
+    //The trailing pages are unmapped in place
+    TEST_ASSERT_EQUAL(addr_1, addr_2);
     TEST_ASSERT_EQUAL(LARGE_CHUNK_SIZE / 2, chunk_2->size);
-    TEST_ASSERT_EQUAL(chunk_2, memory_g.large_head);
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, chunk_2));
+    free(addr_2);
+}
+
+void test_realloc_large_grow_in_place() {
+    const uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    void *addr_1 = realloc(NULL, LARGE_CHUNK_SIZE);
+    void *addr_2 = realloc(NULL, LARGE_CHUNK_SIZE);
+    chunk_t chunk_2 = addr_2 - CHUNK_METADATA_SIZE;
+    void *addr_3;
+
+    if (((uintptr_t)addr_2 + LARGE_CHUNK_SIZE + page_mask) / (page_mask + 1)
+        != ((uintptr_t)addr_1 - CHUNK_METADATA_SIZE) / (page_mask + 1)) {
+        free(addr_1);
+        free(addr_2);
+        TEST_IGNORE_MESSAGE("the second mapping isn't right below the first one");
+        return;
+    }
+    realloc_fill_chunk(chunk_2);
+    //The pages after the second mapping are taken by the first one
+    free(addr_1);
+    addr_3 = realloc(addr_2, LARGE_CHUNK_SIZE * 2);
+    TEST_ASSERT_EQUAL(addr_2, addr_3);
+    TEST_ASSERT_EQUAL(LARGE_CHUNK_SIZE * 2, chunk_2->size);
+    realloc_fill_chunk_test(chunk_2, LARGE_CHUNK_SIZE);
+    memset(addr_3, 0, LARGE_CHUNK_SIZE * 2);
+    free(addr_3);
+}
+
+void test_realloc_large_to_tiny() {
+    void *addr_1 = realloc(NULL, LARGE_CHUNK_SIZE);
+    chunk_t chunk_1 = addr_1 - CHUNK_METADATA_SIZE;
+
+    realloc_fill_chunk(chunk_1);
+    void *addr_2 = realloc(addr_1, TINY_CHUNK_SIZE);
+    chunk_t chunk_2 = addr_2 - CHUNK_METADATA_SIZE;
+    //Sizes served by the zones move back to them
+    TEST_ASSERT_NOT_EQUAL(addr_1, addr_2);
+    TEST_ASSERT_NULL(registry_search(&memory_g.large, chunk_2));
+    realloc_fill_chunk_test(chunk_2, TINY_CHUNK_SIZE);
     free(addr_2);
 }
 
@@ -129,7 +185,7 @@ void test_realloc_small_new_allocation_new_zone() {
     new_chunk = realloc(addr_1, LARGE_CHUNK_SIZE) - CHUNK_METADATA_SIZE;
     realloc_fill_chunk_test(new_chunk, SMALL_CHUNK_SIZE);
     TEST_ASSERT_TRUE(chunk_1->free);
-    TEST_ASSERT_EQUAL(new_chunk, memory_g.large_head);
+    TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, new_chunk));
     TEST_ASSERT_EQUAL(chunk_2, chunk_1->next);
     TEST_ASSERT_EQUAL(LARGE_CHUNK_SIZE, new_chunk->size);
     free(addr_2);
@@ -161,6 +217,7 @@ void realloc_bigger_new_size_contiguous_no_gap_test(size_t chunk_size) {
     chunk_1 = addr_1 - CHUNK_METADATA_SIZE;
     chunk_3 = addr_3 - CHUNK_METADATA_SIZE;
     free(addr_2);
+    realloc_flush();
     realloc_fill_chunk(chunk_1);
     realloc(addr_1, new_chunk_size);
     realloc_fill_chunk_test(chunk_1, chunk_size);
@@ -183,6 +240,7 @@ void realloc_bigger_new_size_contiguous_with_gap_test(size_t chunk_size) {
     chunk_1 = addr_1 - CHUNK_METADATA_SIZE;
     chunk_3 = addr_3 - CHUNK_METADATA_SIZE;
     free(addr_2);
+    realloc_flush();
     realloc_fill_chunk(chunk_1);
     realloc(addr_1, new_chunk_size);
     realloc_fill_chunk_test(chunk_1, chunk_size);
@@ -208,6 +266,7 @@ void realloc_new_allocation_same_zone_test(size_t chunk_size) {
     chunk_1 = addr_1 - CHUNK_METADATA_SIZE;
     chunk_3 = addr_3 - CHUNK_METADATA_SIZE;
     free(addr_2);
+    realloc_flush();
     realloc_fill_chunk(chunk_1);
     new_chunk = realloc(addr_1, new_chunk_size) - CHUNK_METADATA_SIZE;
     realloc_fill_chunk_test(new_chunk, chunk_size / 4);
@@ -234,3 +293,14 @@ void realloc_fill_chunk_test(chunk_t chunk, size_t len) {
         TEST_ASSERT_EQUAL(chunk->data[i], fill++);
     }
 }
+
+/**
+ * @brief Give back the chunks held by the cache and the quick lists, so that
+ * freed chunks are merged with their neighbours like without them
+ */
+void realloc_flush(void) {
+    cache_flush();
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+}
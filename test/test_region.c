@@ -0,0 +1,108 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "region.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "config.h"
+#include "stats.h"
+#include "def.h"
+
+void test_region_bump(void);
+void test_region_reset(void);
+void test_region_big(void);
+void test_region_limit(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_region_bump);
+    RUN_TEST(test_region_reset);
+    RUN_TEST(test_region_big);
+    RUN_TEST(test_region_limit);
+
+    return UNITY_END();
+}
+
+void test_region_bump(void) {
+    region_t region = region_create();
+    uint8_t *addr_1;
+    uint8_t *addr_2;
+
+    TEST_ASSERT_NOT_NULL(region);
+    addr_1 = region_alloc(region, 1);
+    addr_2 = region_alloc(region, 24);
+    //No header between two allocations
+    TEST_ASSERT_EQUAL(addr_1 + ALIGN_SIZE, addr_2);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)addr_2 % ALIGN_SIZE);
+    TEST_ASSERT_EQUAL(addr_2 + ALIGN_MEM(24), region->top);
+    region_destroy(region);
+}
+
+void test_region_reset(void) {
+    region_t region = region_create();
+    uint8_t *first;
+    zone_t second;
+
+    first = region_alloc(region, 64);
+    //Fill more than one zone
+    while (region->current == region->head) {
+        memset(region_alloc(region, SMALL_CHUNK_SIZE), 0xAB, SMALL_CHUNK_SIZE);
+    }
+    second = region->current;
+    region_reset(region);
+    TEST_ASSERT_EQUAL(first, region_alloc(region, 64));
+    //The zones are kept and bumped through again
+    while (region->current == region->head) {
+        region_alloc(region, SMALL_CHUNK_SIZE);
+    }
+    TEST_ASSERT_EQUAL(second, region->current);
+    TEST_ASSERT_NULL(second->next);
+    region_destroy(region);
+}
+
+void test_region_big(void) {
+    region_t region = region_create();
+    const size_t size = MEDIUM_CHUNK_SIZE * 64;
+    uint8_t *small;
+    uint8_t *big;
+    zone_t next;
+
+    big = region_alloc(region, size);
+    TEST_ASSERT_NOT_NULL(big);
+    memset(big, 0xAB, size);
+    TEST_ASSERT_GREATER_OR_EQUAL(size, region->current->size);
+    next = region->current;
+    region_reset(region);
+    small = region_alloc(region, 64);
+    //A big allocation after a reset can reuse the big zone
+    TEST_ASSERT_EQUAL(region->head, region->current);
+    TEST_ASSERT_EQUAL(big, region_alloc(region, size));
+    TEST_ASSERT_EQUAL(next, region->current);
+    TEST_ASSERT_NOT_NULL(small);
+    region_destroy(region);
+}
+
+void test_region_limit(void) {
+    const size_t size = MEDIUM_CHUNK_SIZE * 64;
+    const size_t mapped = memory_g.stats[STATS_LARGE].mapped;
+    region_t region = region_create();
+
+    //Region zones are counted, so the limit sees them
+    TEST_ASSERT_NOT_NULL(region);
+    TEST_ASSERT_EQUAL(mapped + region->head->size + ZONE_METADATA_SIZE, memory_g.stats[STATS_LARGE].mapped);
+    TEST_ASSERT_NOT_NULL(region_alloc(region, region->end - region->top));
+    config_g.limit = stats_mapped() + MEDIUM_CHUNK_SIZE / 2;
+    //Refused by the limit for a zone size, not mapped some other way
+    TEST_ASSERT_NULL(region_alloc(region, MEDIUM_CHUNK_SIZE));
+    TEST_ASSERT_NULL(region_alloc(region, size));
+    config_g.limit = 0;
+    TEST_ASSERT_NOT_NULL(region_alloc(region, size));
+    region_destroy(region);
+    TEST_ASSERT_EQUAL(mapped, memory_g.stats[STATS_LARGE].mapped);
+}
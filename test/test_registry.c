@@ -0,0 +1,92 @@
+#include "unity.h"
+
+#include <stdlib.h>
+
+#include "registry.h"
+#include "malloc.h"
+#include "free.h"
+#include "memory.h"
+
+#define REGISTRY_TEST_COUNT 5000
+#define REGISTRY_TEST_CHUNK(i) ((chunk_t)(0x100000000 + (i) * 4096))
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 2)
+
+void test_registry_insert_search(void);
+void test_registry_remove(void);
+void test_registry_large(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_registry_insert_search);
+    RUN_TEST(test_registry_remove);
+    RUN_TEST(test_registry_large);
+
+    return UNITY_END();
+}
+
+void test_registry_insert_search(void) {
+    registry_t registry = {0};
+    registry_entry_t *entry;
+
+    for (size_t i = 0; i < REGISTRY_TEST_COUNT; i++) {
+        entry = registry_insert(&registry, REGISTRY_TEST_CHUNK(i));
+        TEST_ASSERT_NOT_NULL(entry);
+        entry->size = i;
+    }
+    TEST_ASSERT_EQUAL(REGISTRY_TEST_COUNT, registry.count);
+    TEST_ASSERT_GREATER_OR_EQUAL(REGISTRY_TEST_COUNT * 2, registry.capacity);
+    for (size_t i = 0; i < REGISTRY_TEST_COUNT; i++) {
+        entry = registry_search(&registry, REGISTRY_TEST_CHUNK(i));
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_EQUAL(i, entry->size);
+    }
+    TEST_ASSERT_NULL(registry_search(&registry, REGISTRY_TEST_CHUNK(REGISTRY_TEST_COUNT)));
+    registry_clear(&registry);
+    TEST_ASSERT_NULL(registry_search(&registry, REGISTRY_TEST_CHUNK(0)));
+}
+
+void test_registry_remove(void) {
+    registry_t registry = {0};
+    uint8_t removed[REGISTRY_TEST_COUNT] = {0};
+    size_t i;
+
+    for (i = 0; i < REGISTRY_TEST_COUNT; i++) {
+        registry_insert(&registry, REGISTRY_TEST_CHUNK(i))->size = i;
+    }
+    srand(42);
+    for (size_t j = 0; j < REGISTRY_TEST_COUNT / 2; j++) {
+        i = rand() % REGISTRY_TEST_COUNT;
+        if (!removed[i]) {
+            registry_remove(&registry, registry_search(&registry, REGISTRY_TEST_CHUNK(i)));
+            removed[i] = 1;
+        }
+    }
+    //Every remaining entry must still be reachable after the backward shifts
+    for (i = 0; i < REGISTRY_TEST_COUNT; i++) {
+        if (removed[i]) {
+            TEST_ASSERT_NULL(registry_search(&registry, REGISTRY_TEST_CHUNK(i)));
+        } else {
+            TEST_ASSERT_NOT_NULL(registry_search(&registry, REGISTRY_TEST_CHUNK(i)));
+            TEST_ASSERT_EQUAL(i, registry_search(&registry, REGISTRY_TEST_CHUNK(i))->size);
+        }
+    }
+    registry_clear(&registry);
+}
+
+void test_registry_large(void) {
+    void *addr[64];
+
+    for (size_t i = 0; i < 64; i++) {
+        addr[i] = malloc(LARGE_CHUNK_SIZE);
+        TEST_ASSERT_NOT_NULL(registry_search(&memory_g.large, addr[i] - CHUNK_METADATA_SIZE));
+    }
+    TEST_ASSERT_EQUAL(64, memory_g.large.count);
+    for (size_t i = 0; i < 64; i++) {
+        free(addr[i]);
+    }
+    TEST_ASSERT_EQUAL(0, memory_g.large.count);
+}
@@ -0,0 +1,81 @@
+#define _GNU_SOURCE
+#include "unity.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "malloc.h"
+#include "free.h"
+#include "memory.h"
+#include "dump.h"
+#include "quick.h"
+#include "snapshot.h"
+
+#define LARGE_CHUNK_SIZE (MEDIUM_CHUNK_SIZE * 8)
+
+void test_snapshot_records(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_snapshot_records);
+
+    return UNITY_END();
+}
+
+void test_snapshot_records(void) {
+    const int fd = memfd_create("snapshot", 0);
+    void *addr[3] = {malloc(TINY_CHUNK_SIZE), malloc(SMALL_CHUNK_SIZE), malloc(LARGE_CHUNK_SIZE)};
+    size_t counts[SNAPSHOT_END + 1] = {0};
+    size_t zone_count = 0;
+    size_t chunk_count = 0;
+    snapshot_header_t header;
+    snapshot_record_t record;
+    zone_t heads[] = {memory_g.tiny_head, memory_g.small_head, memory_g.medium_head};
+
+    free(addr[1]);
+    //Marked free once out of the quick lists
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+    //errno is left untouched on success, the handler may have interrupted a syscall
+    errno = ENOENT;
+    TEST_ASSERT_EQUAL(0, dump_snapshot(fd));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    for (size_t i = 0; i < 3; i++) {
+        for (zone_t zone = heads[i]; zone; zone = zone->next) {
+            zone_count++;
+            for (chunk_t chunk = zone_get_chunk(zone); chunk; chunk = chunk->next) {
+                chunk_count++;
+            }
+        }
+    }
+    lseek(fd, 0, SEEK_SET);
+    TEST_ASSERT_EQUAL(sizeof(header), read(fd, &header, sizeof(header)));
+    TEST_ASSERT_EQUAL(SNAPSHOT_MAGIC, header.magic);
+    TEST_ASSERT_EQUAL(SNAPSHOT_VERSION, header.version);
+    TEST_ASSERT_EQUAL(memory_g.tick, header.tick);
+    TEST_ASSERT_EQUAL(memory_g.tiny_max, header.tiny_max);
+    TEST_ASSERT_EQUAL(memory_g.small_max, header.small_max);
+    while (read(fd, &record, sizeof(record)) == sizeof(record)) {
+        TEST_ASSERT_TRUE(record.type <= SNAPSHOT_END);
+        counts[record.type]++;
+        if (record.type == SNAPSHOT_CHUNK && record.address == (uintptr_t)addr[1] - CHUNK_METADATA_SIZE) {
+            TEST_ASSERT_EQUAL(1, record.free);
+        }
+        if (record.type == SNAPSHOT_LARGE) {
+            TEST_ASSERT_EQUAL((uintptr_t)addr[2] - CHUNK_METADATA_SIZE, record.address);
+        }
+    }
+    TEST_ASSERT_EQUAL(zone_count, counts[SNAPSHOT_ZONE]);
+    TEST_ASSERT_EQUAL(chunk_count, counts[SNAPSHOT_CHUNK]);
+    TEST_ASSERT_EQUAL(memory_g.large.count, counts[SNAPSHOT_LARGE]);
+    TEST_ASSERT_EQUAL(1, counts[SNAPSHOT_END]);
+    free(addr[0]);
+    free(addr[2]);
+    close(fd);
+}
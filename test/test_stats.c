@@ -0,0 +1,134 @@
+#include "unity.h"
+
+#include <stdlib.h>
+
+#include "malloc.h"
+#include "realloc.h"
+#include "free.h"
+#include "memory.h"
+#include "stats.h"
+#include "def.h"
+
+#define STATS_TEST_COUNT 2000
+
+void test_stats_match_walk(void);
+void test_stats_internal_fragmentation(void);
+void test_stats_external_fragmentation(void);
+static void stats_check(stats_class_t class, zone_t zone);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_stats_match_walk);
+    RUN_TEST(test_stats_internal_fragmentation);
+    RUN_TEST(test_stats_external_fragmentation);
+
+    return UNITY_END();
+}
+
+void test_stats_match_walk(void) {
+    static void *addr[STATS_TEST_COUNT];
+    size_t size;
+
+    srand(42);
+    for (size_t i = 0; i < STATS_TEST_COUNT; i++) {
+        size = (size_t)rand() % (MEDIUM_CHUNK_SIZE * 2);
+        addr[i] = malloc(size % 3 == 0 ? size : size % SMALL_CHUNK_SIZE);
+    }
+    for (size_t i = 0; i < STATS_TEST_COUNT; i += 3) {
+        free(addr[i]);
+        addr[i] = NULL;
+    }
+    for (size_t i = 1; i < STATS_TEST_COUNT; i += 3) {
+        addr[i] = realloc(addr[i], (size_t)rand() % (SMALL_CHUNK_SIZE * 2));
+    }
+    stats_check(STATS_TINY, memory_g.tiny_head);
+    stats_check(STATS_SMALL, memory_g.small_head);
+    stats_check(STATS_MEDIUM, memory_g.medium_head);
+    TEST_ASSERT_EQUAL(memory_g.large.count, memory_g.stats[STATS_LARGE].zone_count);
+    TEST_ASSERT_EQUAL(memory_g.large.count, memory_g.stats[STATS_LARGE].used_count);
+    for (size_t i = 0; i < STATS_TEST_COUNT; i++) {
+        free(addr[i]);
+    }
+    stats_check(STATS_TINY, memory_g.tiny_head);
+    stats_check(STATS_SMALL, memory_g.small_head);
+    stats_check(STATS_MEDIUM, memory_g.medium_head);
+    TEST_ASSERT_EQUAL(0, memory_g.stats[STATS_LARGE].used_count);
+    TEST_ASSERT_EQUAL(0, memory_g.stats[STATS_LARGE].mapped);
+}
+
+void test_stats_internal_fragmentation(void) {
+    const size_t size = TINY_CHUNK_SIZE + 1;
+    stats_t before;
+    stats_t after;
+    chunk_t chunk;
+
+    //Small sizes always go through chunk_get, even with MALLOC_CACHE
+    stats_get(STATS_SMALL, &before);
+    chunk = malloc(size) - CHUNK_METADATA_SIZE;
+    stats_get(STATS_SMALL, &after);
+    TEST_ASSERT_EQUAL(before.requested + size, after.requested);
+    TEST_ASSERT_EQUAL(before.granted + chunk->size + CHUNK_METADATA_SIZE, after.granted);
+    TEST_ASSERT_TRUE(chunk->size >= ALIGN_MEM(size));
+    TEST_ASSERT_TRUE(stats_internal_fragmentation(STATS_SMALL) > 0);
+    free(chunk->data);
+}
+
+void test_stats_external_fragmentation(void) {
+    void *addr[8];
+
+    for (size_t i = 0; i < 8; i++) {
+        addr[i] = malloc(SMALL_CHUNK_SIZE);
+    }
+    for (size_t i = 0; i < 8; i += 2) {
+        free(addr[i]);
+    }
+    //The holes can't serve an allocation as big as their sum
+    TEST_ASSERT_TRUE(stats_max_free(STATS_SMALL) >= SMALL_CHUNK_SIZE);
+    TEST_ASSERT_TRUE(stats_external_fragmentation(STATS_SMALL) > 0);
+    TEST_ASSERT_TRUE(stats_external_fragmentation(STATS_SMALL) < 1);
+    for (size_t i = 1; i < 8; i += 2) {
+        free(addr[i]);
+    }
+}
+
+/**
+ * @brief Compare the incremental counters of a class with a walk of its zones
+ */
+static void stats_check(stats_class_t class, zone_t zone) {
+    const stats_t *stats = &memory_g.stats[class];
+    size_t zone_count = 0;
+    size_t mapped = 0;
+    size_t used_count = 0;
+    size_t used_size = 0;
+    size_t free_count = 0;
+    size_t free_size = 0;
+    size_t histogram_count = 0;
+
+    for (; zone; zone = zone->next) {
+        zone_count++;
+        mapped += zone->size + ZONE_METADATA_SIZE;
+        for (chunk_t chunk = zone_get_chunk(zone); chunk; chunk = chunk->next) {
+            if (chunk->free) {
+                free_count++;
+                free_size += chunk->size;
+            } else {
+                used_count++;
+                used_size += chunk->size;
+            }
+        }
+    }
+    for (size_t i = 0; i < STATS_BUCKET_COUNT; i++) {
+        histogram_count += stats->free_histogram[i];
+    }
+    TEST_ASSERT_EQUAL(zone_count, stats->zone_count);
+    TEST_ASSERT_EQUAL(mapped, stats->mapped);
+    TEST_ASSERT_EQUAL(used_count, stats->used_count);
+    TEST_ASSERT_EQUAL(used_size, stats->used_size);
+    TEST_ASSERT_EQUAL(free_count, stats->free_count);
+    TEST_ASSERT_EQUAL(free_size, stats->free_size);
+    TEST_ASSERT_EQUAL(free_count, histogram_count);
+}
@@ -0,0 +1,131 @@
+#include "unity.h"
+
+#include "tree.h"
+#include "chunk.h"
+#include "free.h"
+#include "malloc.h"
+#include "zone.h"
+#include "memory.h"
+#include "def.h"
+
+#define TREE_CHUNK_COUNT 256
+
+void test_tree_search(void);
+void test_tree_same_size(void);
+void test_tree_balance(void);
+void test_tree_best_fit_malloc(void);
+static chunk_t tree_chunk_new(size_t size);
+static chunk_t tree_search_linear(chunk_t *chunks, size_t count, size_t size);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_tree_search);
+    RUN_TEST(test_tree_same_size);
+    RUN_TEST(test_tree_balance);
+    RUN_TEST(test_tree_best_fit_malloc);
+
+    return UNITY_END();
+}
+
+void test_tree_search(void) {
+    chunk_t root = NULL;
+    chunk_t chunks[TREE_CHUNK_COUNT];
+
+    for (size_t i = 0; i < TREE_CHUNK_COUNT; i++) {
+        //Sizes are spread so that the insertion order isn't sorted
+        chunks[i] = tree_chunk_new(ALIGN_MEM(TREE_MIN_SIZE + (i * 7919) % 4096));
+        tree_insert(&root, chunks[i]);
+    }
+    for (size_t size = 0; size < 4096 + 2 * ALIGN_SIZE; size += ALIGN_SIZE) {
+        TEST_ASSERT_EQUAL(tree_search_linear(chunks, TREE_CHUNK_COUNT, size), tree_search(root, size));
+    }
+    //Remove every other chunk, the search must skip them
+    for (size_t i = 0; i < TREE_CHUNK_COUNT; i += 2) {
+        tree_remove(&root, chunks[i]);
+        chunks[i]->size = 0;
+    }
+    for (size_t size = ALIGN_SIZE; size < 4096 + 2 * ALIGN_SIZE; size += ALIGN_SIZE) {
+        TEST_ASSERT_EQUAL(tree_search_linear(chunks, TREE_CHUNK_COUNT, size), tree_search(root, size));
+    }
+}
+
+void test_tree_same_size(void) {
+    chunk_t root = NULL;
+    chunk_t chunks[8];
+
+    for (size_t i = 0; i < 8; i++) {
+        chunks[i] = tree_chunk_new(256);
+        tree_insert(&root, chunks[i]);
+    }
+    //Ties are broken by address
+    TEST_ASSERT_EQUAL(tree_search_linear(chunks, 8, 256), tree_search(root, 200));
+    for (size_t i = 0; i < 8; i++) {
+        tree_remove(&root, tree_search(root, 256));
+    }
+    TEST_ASSERT_NULL(root);
+}
+
+void test_tree_balance(void) {
+    chunk_t root = NULL;
+    chunk_t chunk;
+
+    //Chunks are inserted in increasing order, the worst case for an unbalanced tree
+    for (size_t i = 0; i < TREE_CHUNK_COUNT; i++) {
+        chunk = tree_chunk_new(ALIGN_MEM(TREE_MIN_SIZE));
+        chunk->size += i * ALIGN_SIZE;
+        tree_insert(&root, chunk);
+    }
+    //An AVL tree is never higher than 1.44 * log2(n)
+    TEST_ASSERT_LESS_OR_EQUAL(12, tree_height(root));
+}
+
+void test_tree_best_fit_malloc(void) {
+#ifdef MALLOC_BEST_FIT
+    void *large_hole = malloc(2000);
+    void *separator_1 = malloc(200);
+    void *exact_hole = malloc(304);
+    void *separator_2 = malloc(200);
+
+    free(large_hole);
+    free(exact_hole);
+    //Nodes know their zone, found without walking the zones
+    TEST_ASSERT_EQUAL(zone_validate((uintptr_t)exact_hole, memory_g.small_head),
+                      TREE_ZONE((chunk_t)(exact_hole - CHUNK_METADATA_SIZE)));
+    //First-fit would split the 2000 bytes chunk
+    TEST_ASSERT_EQUAL(exact_hole, malloc(304));
+    TEST_ASSERT_EQUAL(large_hole, malloc(2000));
+    free(large_hole);
+    free(exact_hole);
+    free(separator_1);
+    free(separator_2);
+#else
+    TEST_IGNORE_MESSAGE("MALLOC_BEST_FIT is disabled");
+#endif
+}
+
+static chunk_t tree_chunk_new(size_t size) {
+    chunk_t chunk = chunk_new(size);
+
+    chunk_init(chunk, size);
+    chunk->free = 1;
+    return chunk;
+}
+
+static chunk_t tree_search_linear(chunk_t *chunks, size_t count, size_t size) {
+    chunk_t best = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        if (chunks[i]->size < size || chunks[i]->size == 0) {
+            continue;
+        }
+        if (best == NULL || chunks[i]->size < best->size
+            || (chunks[i]->size == best->size && chunks[i] < best)) {
+            best = chunks[i];
+        }
+    }
+    return best;
+}
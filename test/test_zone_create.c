@@ -6,6 +6,7 @@
 
 static void zone_create_test(size_t requested_size, size_t chunk_size);
 void test_zone_create_tiny(void);
+void test_zone_create_medium(void);
 
 void setUp(void) {}
 void tearDown(void) {}
@@ -14,6 +15,7 @@ int main(void) {
     UNITY_BEGIN();
 
     RUN_TEST(test_zone_create_tiny);
+    RUN_TEST(test_zone_create_medium);
 
     return UNITY_END();
 }
@@ -30,8 +32,25 @@ void test_zone_create_small(void) {
     zone_create_test(SMALL_CHUNK_SIZE, SMALL_CHUNK_SIZE);
 }
 
+void test_zone_create_medium(void) {
+    const size_t chunk_size = chunk_round_size(MEDIUM_CHUNK_SIZE);
+    zone_t zone = zone_new(NULL, chunk_size);
+    chunk_t chunk;
+
+    TEST_ASSERT_NOT_NULL(zone);
+    //MEDIUM_CHUNK_PER_ZONE page-rounded chunks fit, each with its metadata
+    TEST_ASSERT_GREATER_OR_EQUAL((chunk_size + CHUNK_METADATA_SIZE) * MEDIUM_CHUNK_PER_ZONE,
+                                 zone->size);
+    chunk = zone_get_chunk(zone);
+    for (size_t i = 0; i < MEDIUM_CHUNK_PER_ZONE - 1; i++) {
+        chunk = chunk_split(chunk, chunk_size);
+        TEST_ASSERT_NOT_NULL(chunk);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(chunk_size, chunk->size);
+}
+
 void test_zone_create_large(void) {
-    TEST_ASSERT_NULL(zone_new(NULL, SMALL_CHUNK_SIZE + 1));
+    TEST_ASSERT_NULL(zone_new(NULL, chunk_round_size(MEDIUM_CHUNK_SIZE) + 1));
 }
 
 static void zone_create_test(size_t requested_size, size_t chunk_size) {
@@ -54,7 +73,11 @@ static void zone_create_test(size_t requested_size, size_t chunk_size) {
     TEST_ASSERT_NULL(chunk->prev);
     TEST_ASSERT_EQUAL(chunk->free, 1);
     TEST_ASSERT_EQUAL(chunk->data, (void*)chunk + CHUNK_METADATA_SIZE);
+#ifdef MALLOC_HARDENING_HARDENED
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+#else
     TEST_ASSERT_EQUAL((chunk->magic >> 8), chunk->data);
+#endif
 
     last = zone;
     zone = zone_new(last, requested_size);
@@ -71,5 +94,9 @@ static void zone_create_test(size_t requested_size, size_t chunk_size) {
     TEST_ASSERT_NULL(chunk->prev);
     TEST_ASSERT_EQUAL(chunk->free, 1);
     TEST_ASSERT_EQUAL(chunk->data, (void*)chunk + CHUNK_METADATA_SIZE);
+#ifdef MALLOC_HARDENING_HARDENED
+    TEST_ASSERT_TRUE(chunk_check(chunk));
+#else
     TEST_ASSERT_EQUAL((chunk->magic >> 8), chunk->data);
+#endif
 }
\ No newline at end of file
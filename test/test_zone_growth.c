@@ -0,0 +1,69 @@
+#include "unity.h"
+
+#include "malloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "cache.h"
+#include "quick.h"
+#include "stats.h"
+
+#define GROWTH_COUNT    (CHUNK_PER_ZONE * 256)
+
+void test_zone_growth(void);
+void test_zone_growth_shrink(void);
+
+static void *addrs_g[GROWTH_COUNT];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zone_growth);
+    RUN_TEST(test_zone_growth_shrink);
+
+    return UNITY_END();
+}
+
+void test_zone_growth(void) {
+    const size_t min_size = zone_mapping_size(TINY_CHUNK_SIZE);
+    size_t zone_count = 0;
+    size_t previous = 0;
+
+    //The first zones keep the smallest size
+    TEST_ASSERT_EQUAL(min_size, zone_growth_size(&memory_g.tiny_head, TINY_CHUNK_SIZE));
+    for (size_t i = 0; i < GROWTH_COUNT; i++) {
+        addrs_g[i] = malloc(TINY_CHUNK_SIZE);
+        TEST_ASSERT_NOT_NULL(addrs_g[i]);
+    }
+    //New zones are appended, each at least as big as the previous one
+    for (zone_t zone = memory_g.tiny_head; zone; zone = zone->next) {
+        TEST_ASSERT_GREATER_OR_EQUAL(previous, zone->size);
+        TEST_ASSERT_LESS_OR_EQUAL(ZONE_GROWTH_MAX, zone->size + ZONE_METADATA_SIZE);
+        previous = zone->size;
+        zone_count++;
+    }
+    TEST_ASSERT_EQUAL(zone_count, memory_g.stats[STATS_TINY].zone_count);
+    //Fixed size zones would need one zone per CHUNK_PER_ZONE chunks
+    TEST_ASSERT_LESS_THAN(GROWTH_COUNT / CHUNK_PER_ZONE / 8, zone_count);
+    TEST_ASSERT_GREATER_THAN(min_size, zone_growth_size(&memory_g.tiny_head, TINY_CHUNK_SIZE));
+}
+
+void test_zone_growth_shrink(void) {
+    const size_t min_size = zone_mapping_size(TINY_CHUNK_SIZE);
+
+    for (size_t i = 0; i < GROWTH_COUNT; i++) {
+        free(addrs_g[i]);
+    }
+    //Chunks kept aside by the cache or the quick lists keep their zones used
+    cache_flush();
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+    //Only one empty zone is kept, the next zone starts small again
+    TEST_ASSERT_EQUAL(1, memory_g.stats[STATS_TINY].zone_count);
+    TEST_ASSERT_EQUAL(min_size, zone_growth_size(&memory_g.tiny_head, TINY_CHUNK_SIZE));
+}
@@ -0,0 +1,127 @@
+#include "unity.h"
+
+#include <stdlib.h>
+
+#include "malloc.h"
+#include "realloc.h"
+#include "free.h"
+#include "chunk.h"
+#include "zone.h"
+#include "memory.h"
+#include "cache.h"
+#include "quick.h"
+
+#define ZONE_SEARCH_SLOTS  512
+#define ZONE_SEARCH_ROUNDS 20000
+
+void test_zone_search_free_size(void);
+void test_zone_search_rover(void);
+void test_zone_search_hints(void);
+static void zone_search_check(zone_t zone);
+static void zone_search_flush(void);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zone_search_free_size);
+    RUN_TEST(test_zone_search_rover);
+    RUN_TEST(test_zone_search_hints);
+
+    return UNITY_END();
+}
+
+void test_zone_search_free_size(void) {
+    void *addr = malloc(TINY_CHUNK_SIZE);
+    zone_t zone = memory_g.tiny_head;
+
+    TEST_ASSERT_EQUAL(zone->size - TINY_CHUNK_SIZE - CHUNK_METADATA_SIZE, zone->free_size);
+    addr = realloc(addr, TINY_CHUNK_SIZE / 2);
+    TEST_ASSERT_EQUAL(zone->size - TINY_CHUNK_SIZE / 2 - CHUNK_METADATA_SIZE, zone->free_size);
+    free(addr);
+    zone_search_flush();
+    TEST_ASSERT_EQUAL(zone->size, zone->free_size);
+    TEST_ASSERT_EQUAL(zone->size - CHUNK_METADATA_SIZE, zone->max_free);
+}
+
+void test_zone_search_rover(void) {
+    void *addr[CHUNK_PER_ZONE * 2];
+    zone_t first;
+    size_t count = 0;
+
+    //Fill the first zone, allocations then go to the second one
+    do {
+        addr[count++] = malloc(TINY_CHUNK_SIZE);
+    } while (memory_g.tiny_head->next == NULL);
+    first = memory_g.tiny_head;
+    TEST_ASSERT_EQUAL(first->next, memory_g.tiny_rover);
+    //The first zone was found full, so it's skipped by the next searches
+    TEST_ASSERT_LESS_THAN(TINY_CHUNK_SIZE, first->max_free);
+    addr[count++] = malloc(TINY_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(first->next, memory_g.tiny_rover);
+    //Freeing in the first zone makes it eligible again
+    free(addr[0]);
+    zone_search_flush();
+    TEST_ASSERT_GREATER_OR_EQUAL(TINY_CHUNK_SIZE, first->max_free);
+    for (size_t i = 1; i < count; i++) {
+        free(addr[i]);
+    }
+    zone_search_check(memory_g.tiny_head);
+}
+
+void test_zone_search_hints(void) {
+    void *addr[ZONE_SEARCH_SLOTS] = {0};
+    size_t slot;
+
+    srand(42);
+    for (size_t i = 0; i < ZONE_SEARCH_ROUNDS; i++) {
+        slot = rand() % ZONE_SEARCH_SLOTS;
+        if (addr[slot] && i % 3 == 0) {
+            addr[slot] = realloc(addr[slot], rand() % SMALL_CHUNK_SIZE + 1);
+        } else if (addr[slot]) {
+            free(addr[slot]);
+            addr[slot] = NULL;
+        } else {
+            addr[slot] = malloc(rand() % SMALL_CHUNK_SIZE + 1);
+        }
+    }
+    zone_search_check(memory_g.tiny_head);
+    zone_search_check(memory_g.small_head);
+    for (size_t i = 0; i < ZONE_SEARCH_SLOTS; i++) {
+        free(addr[i]);
+    }
+}
+
+static void zone_search_check(zone_t zone) {
+    chunk_t chunk;
+    size_t free_size;
+    size_t max_free;
+
+    while (zone) {
+        free_size = zone->size;
+        max_free = 0;
+        for (chunk = zone_get_chunk(zone); chunk; chunk = chunk->next) {
+            if (!chunk->free) {
+                free_size -= chunk->size + CHUNK_METADATA_SIZE;
+            } else if (chunk->size > max_free) {
+                max_free = chunk->size;
+            }
+        }
+        TEST_ASSERT_EQUAL(free_size, zone->free_size);
+        TEST_ASSERT_GREATER_OR_EQUAL(max_free, zone->max_free);
+        zone = zone->next;
+    }
+}
+
+/**
+ * @brief Chunks held by the cache or the quick lists are still used for
+ * their zone, give them back
+ */
+static void zone_search_flush(void) {
+    cache_flush();
+    memory_lock();
+    quick_flush(NULL);
+    memory_unlock();
+}
@@ -0,0 +1,453 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "chunk.h"
+#include "zone.h"
+#include "stats.h"
+#include "snapshot.h"
+
+#define HEATMAP_WIDTH   64
+#define HEATMAP_LEVELS  " .:-=+*#%@"
+
+typedef struct {
+    uint8_t     class;
+    uint64_t    address;
+    uint64_t    size;
+    size_t      first_chunk;    // Index of its first chunk in snapshot_t.chunks
+    size_t      chunk_count;
+} zone_record_t;
+
+typedef struct {
+    uint8_t     class;
+    bool        free;
+    uint64_t    address;
+    uint64_t    size;
+} chunk_record_t;
+
+typedef struct {
+    snapshot_header_t   header;
+    zone_record_t       *zones;
+    size_t              zone_count;
+    chunk_record_t      *chunks;    // Zone chunks, then large mappings
+    size_t              chunk_count;
+} snapshot_t;
+
+typedef struct {
+    size_t  zones;
+    size_t  mapped;
+    size_t  used_count;
+    size_t  used_size;
+    size_t  free_count;
+    size_t  free_size;
+    size_t  max_free;
+} summary_t;
+
+typedef struct {
+    size_t  tiny_max;
+    size_t  small_max;
+    size_t  medium_max;
+} layout_t;
+
+static const char *class_names_g[STATS_CLASS_COUNT] = {"TINY", "SMALL", "MEDIUM", "LARGE"};
+
+static bool     snapshot_load(const char *path, snapshot_t *snapshot);
+static void     snapshot_summary(const snapshot_t *snapshot, summary_t summary[STATS_CLASS_COUNT]);
+static int      command_summary(const snapshot_t *snapshot);
+static int      command_diff(const snapshot_t *before, const snapshot_t *after);
+static int      command_heatmap(const snapshot_t *snapshot, size_t width);
+static int      command_layout(const snapshot_t *snapshot, const layout_t *layout);
+static size_t   layout_estimate(const snapshot_t *snapshot, const layout_t *layout, size_t mapped[STATS_CLASS_COUNT]);
+static size_t   layout_zones(size_t bytes, size_t min_size, size_t page_size);
+static size_t   page_round(size_t size, size_t page_size);
+static int      chunk_compare(const void *a, const void *b);
+static void     usage(const char *name);
+
+int main(int argc, char **argv) {
+    snapshot_t snapshot;
+    snapshot_t other;
+    layout_t layout;
+
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!snapshot_load(argv[2], &snapshot)) {
+        return 1;
+    }
+    if (strcmp(argv[1], "summary") == 0) {
+        return command_summary(&snapshot);
+    }
+    if (strcmp(argv[1], "diff") == 0 && argc == 4) {
+        if (!snapshot_load(argv[3], &other)) {
+            return 1;
+        }
+        return command_diff(&snapshot, &other);
+    }
+    if (strcmp(argv[1], "heatmap") == 0) {
+        return command_heatmap(&snapshot, argc > 3 ? strtoul(argv[3], NULL, 10) : HEATMAP_WIDTH);
+    }
+    if (strcmp(argv[1], "layout") == 0 && argc == 6) {
+        layout.tiny_max = strtoul(argv[3], NULL, 10);
+        layout.small_max = strtoul(argv[4], NULL, 10);
+        layout.medium_max = strtoul(argv[5], NULL, 10);
+        return command_layout(&snapshot, &layout);
+    }
+    usage(argv[0]);
+    return 2;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s summary SNAPSHOT\n"
+            "       %s diff BEFORE AFTER\n"
+            "       %s heatmap SNAPSHOT [WIDTH]\n"
+            "       %s layout SNAPSHOT TINY_MAX SMALL_MAX MEDIUM_MAX\n",
+            name, name, name, name);
+}
+
+/**
+ * @brief Read a snapshot written by dump_snapshot
+ * @param path The snapshot file
+ * @param snapshot Filled with the zones and chunks of the file
+ * @return false if the file can't be read or is truncated
+ */
+static bool snapshot_load(const char *path, snapshot_t *snapshot) {
+    FILE *file = fopen(path, "rb");
+    snapshot_record_t record;
+    size_t zone_capacity = 64;
+    size_t chunk_capacity = 1024;
+    bool end = false;
+
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (fread(&snapshot->header, sizeof(snapshot->header), 1, file) != 1
+        || snapshot->header.magic != SNAPSHOT_MAGIC
+        || snapshot->header.version != SNAPSHOT_VERSION) {
+        fprintf(stderr, "%s: not a snapshot\n", path);
+        fclose(file);
+        return false;
+    }
+    snapshot->zones = malloc(zone_capacity * sizeof(*snapshot->zones));
+    snapshot->chunks = malloc(chunk_capacity * sizeof(*snapshot->chunks));
+    while (!end && fread(&record, sizeof(record), 1, file) == 1) {
+        if (snapshot->zone_count == zone_capacity) {
+            zone_capacity *= 2;
+            snapshot->zones = realloc(snapshot->zones, zone_capacity * sizeof(*snapshot->zones));
+        }
+        if (snapshot->chunk_count == chunk_capacity) {
+            chunk_capacity *= 2;
+            snapshot->chunks = realloc(snapshot->chunks, chunk_capacity * sizeof(*snapshot->chunks));
+        }
+        if (snapshot->zones == NULL || snapshot->chunks == NULL) {
+            fprintf(stderr, "%s: out of memory\n", path);
+            break;
+        }
+        switch (record.type) {
+            case SNAPSHOT_ZONE:
+                snapshot->zones[snapshot->zone_count++] = (zone_record_t){
+                    record.class, record.address, record.size, snapshot->chunk_count, 0
+                };
+                break;
+            case SNAPSHOT_CHUNK:
+                if (snapshot->zone_count > 0) {
+                    snapshot->zones[snapshot->zone_count - 1].chunk_count++;
+                }
+                //fall through
+            case SNAPSHOT_LARGE:
+                snapshot->chunks[snapshot->chunk_count++] = (chunk_record_t){
+                    record.class, record.free, record.address, record.size
+                };
+                break;
+            default:
+                end = true;
+        }
+    }
+    fclose(file);
+    if (!end) {
+        fprintf(stderr, "%s: truncated snapshot\n", path);
+    }
+    return end;
+}
+
+static void snapshot_summary(const snapshot_t *snapshot, summary_t summary[STATS_CLASS_COUNT]) {
+    const chunk_record_t *chunk;
+    summary_t *class;
+
+    memset(summary, 0, sizeof(*summary) * STATS_CLASS_COUNT);
+    for (size_t i = 0; i < snapshot->zone_count; i++) {
+        summary[snapshot->zones[i].class].zones++;
+        summary[snapshot->zones[i].class].mapped += snapshot->zones[i].size + ZONE_METADATA_SIZE;
+    }
+    for (size_t i = 0; i < snapshot->chunk_count; i++) {
+        chunk = &snapshot->chunks[i];
+        class = &summary[chunk->class];
+        if (chunk->class == STATS_LARGE) {
+            //Large mappings are recorded with their metadata
+            class->zones++;
+            class->mapped += page_round(chunk->size, snapshot->header.page_size);
+            class->used_count++;
+            class->used_size += chunk->size - CHUNK_METADATA_SIZE;
+        } else if (chunk->free) {
+            class->free_count++;
+            class->free_size += chunk->size;
+            if (chunk->size > class->max_free) {
+                class->max_free = chunk->size;
+            }
+        } else {
+            class->used_count++;
+            class->used_size += chunk->size;
+        }
+    }
+}
+
+static int command_summary(const snapshot_t *snapshot) {
+    summary_t summary[STATS_CLASS_COUNT];
+    const summary_t *class;
+
+    snapshot_summary(snapshot, summary);
+    printf("tick %llu, large threshold %llu\n",
+           (unsigned long long)snapshot->header.tick, (unsigned long long)snapshot->header.large_threshold);
+    printf("%-7s %8s %12s %10s %12s %10s %12s %12s %7s\n", "class", "zones", "mapped",
+           "used", "used bytes", "free", "free bytes", "max free", "ext.%");
+    for (size_t i = 0; i < STATS_CLASS_COUNT; i++) {
+        class = &summary[i];
+        printf("%-7s %8zu %12zu %10zu %12zu %10zu %12zu %12zu %6.1f%%\n", class_names_g[i],
+               class->zones, class->mapped, class->used_count, class->used_size,
+               class->free_count, class->free_size, class->max_free,
+               class->free_size ? (1 - (double)class->max_free / class->free_size) * 100 : 0);
+    }
+    return 0;
+}
+
+/**
+ * @brief Print the per-class changes between two snapshots, and the chunks
+ * allocated or released in between, matched by address and size
+ */
+static int command_diff(const snapshot_t *before, const snapshot_t *after) {
+    summary_t old[STATS_CLASS_COUNT];
+    summary_t new[STATS_CLASS_COUNT];
+    chunk_record_t *a = malloc(before->chunk_count * sizeof(*a) + 1);
+    chunk_record_t *b = malloc(after->chunk_count * sizeof(*b) + 1);
+    size_t allocated[2] = {0};
+    size_t released[2] = {0};
+    size_t i = 0;
+    size_t j = 0;
+    int cmp;
+
+    if (a == NULL || b == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    snapshot_summary(before, old);
+    snapshot_summary(after, new);
+    printf("ticks %llu -> %llu\n",
+           (unsigned long long)before->header.tick, (unsigned long long)after->header.tick);
+    printf("%-7s %8s %12s %12s %12s\n", "class", "zones", "mapped", "used bytes", "free bytes");
+    for (size_t c = 0; c < STATS_CLASS_COUNT; c++) {
+        printf("%-7s %+8zd %+12zd %+12zd %+12zd\n", class_names_g[c],
+               (ssize_t)(new[c].zones - old[c].zones), (ssize_t)(new[c].mapped - old[c].mapped),
+               (ssize_t)(new[c].used_size - old[c].used_size), (ssize_t)(new[c].free_size - old[c].free_size));
+    }
+    //Only used chunks are matched, free chunks move with every fusion
+    memcpy(a, before->chunks, before->chunk_count * sizeof(*a));
+    memcpy(b, after->chunks, after->chunk_count * sizeof(*b));
+    qsort(a, before->chunk_count, sizeof(*a), chunk_compare);
+    qsort(b, after->chunk_count, sizeof(*b), chunk_compare);
+    while (i < before->chunk_count || j < after->chunk_count) {
+        if (i < before->chunk_count && a[i].free) {
+            i++;
+            continue;
+        }
+        if (j < after->chunk_count && b[j].free) {
+            j++;
+            continue;
+        }
+        if (i == before->chunk_count) {
+            cmp = 1;
+        } else if (j == after->chunk_count) {
+            cmp = -1;
+        } else {
+            cmp = chunk_compare(&a[i], &b[j]);
+        }
+        if (cmp < 0) {
+            released[0]++;
+            released[1] += a[i++].size;
+        } else if (cmp > 0) {
+            allocated[0]++;
+            allocated[1] += b[j++].size;
+        } else {
+            i++;
+            j++;
+        }
+    }
+    printf("allocated: %zu chunks, %zu bytes\n", allocated[0], allocated[1]);
+    printf("released:  %zu chunks, %zu bytes\n", released[0], released[1]);
+    free(a);
+    free(b);
+    return 0;
+}
+
+/**
+ * @brief Draw one line per zone, each cell showing how much of its part of
+ * the zone is used, headers of used chunks included
+ */
+static int command_heatmap(const snapshot_t *snapshot, size_t width) {
+    const size_t levels = strlen(HEATMAP_LEVELS) - 1;
+    const zone_record_t *zone;
+    const chunk_record_t *chunk;
+    uint64_t cell_start;
+    uint64_t cell_end;
+    uint64_t start;
+    uint64_t end;
+    uint64_t used;
+
+    if (width == 0) {
+        width = HEATMAP_WIDTH;
+    }
+    for (size_t z = 0; z < snapshot->zone_count; z++) {
+        zone = &snapshot->zones[z];
+        printf("%-6s 0x%012llx |", class_names_g[zone->class], (unsigned long long)zone->address);
+        for (size_t cell = 0; cell < width; cell++) {
+            cell_start = zone->address + ZONE_METADATA_SIZE + zone->size * cell / width;
+            cell_end = zone->address + ZONE_METADATA_SIZE + zone->size * (cell + 1) / width;
+            used = 0;
+            for (size_t c = zone->first_chunk; c < zone->first_chunk + zone->chunk_count; c++) {
+                chunk = &snapshot->chunks[c];
+                start = chunk->address;
+                end = chunk->address + CHUNK_METADATA_SIZE + chunk->size;
+                if (chunk->free || end <= cell_start || start >= cell_end) {
+                    continue;
+                }
+                used += (end < cell_end ? end : cell_end) - (start > cell_start ? start : cell_start);
+            }
+            putchar(HEATMAP_LEVELS[cell_end > cell_start ? used * levels / (cell_end - cell_start) : 0]);
+        }
+        printf("|\n");
+    }
+    return 0;
+}
+
+/**
+ * @brief Compare the memory the used chunks would need with the class
+ * boundaries the process had when the snapshot was taken and with \a layout,
+ * both with perfectly packed zones
+ */
+static int command_layout(const snapshot_t *snapshot, const layout_t *layout) {
+    const layout_t current = {snapshot->header.tiny_max, snapshot->header.small_max, snapshot->header.large_threshold};
+    summary_t summary[STATS_CLASS_COUNT];
+    size_t current_mapped[STATS_CLASS_COUNT];
+    size_t layout_mapped[STATS_CLASS_COUNT];
+    size_t mapped = 0;
+    size_t current_total;
+    size_t layout_total;
+
+    if (layout->tiny_max == 0 || layout->tiny_max >= layout->small_max || layout->small_max >= layout->medium_max) {
+        fprintf(stderr, "the class boundaries must be increasing\n");
+        return 2;
+    }
+    snapshot_summary(snapshot, summary);
+    for (size_t i = 0; i < STATS_CLASS_COUNT; i++) {
+        mapped += summary[i].mapped;
+    }
+    current_total = layout_estimate(snapshot, &current, current_mapped);
+    layout_total = layout_estimate(snapshot, layout, layout_mapped);
+    printf("%-7s %14s %14s\n", "class", "current", "proposed");
+    for (size_t i = 0; i < STATS_CLASS_COUNT; i++) {
+        printf("%-7s %14zu %14zu\n", class_names_g[i], current_mapped[i], layout_mapped[i]);
+    }
+    printf("mapped now:            %zu bytes\n", mapped);
+    printf("lost to fragmentation: %zd bytes\n", (ssize_t)(mapped - current_total));
+    printf("estimated saving:      %zd bytes (%.1f%%)\n", (ssize_t)(current_total - layout_total),
+           current_total ? (1 - (double)layout_total / current_total) * 100 : 0);
+    return 0;
+}
+
+/**
+ * @brief Estimate the memory mapped for the used chunks of a snapshot if they
+ * were served with the class boundaries of \a layout. Zones grow as
+ * zone_growth_size makes them and are assumed perfectly packed, so the result
+ * is a lower bound.
+ * @return The total estimate, per class estimates are written in \a mapped
+ */
+static size_t layout_estimate(const snapshot_t *snapshot, const layout_t *layout, size_t mapped[STATS_CLASS_COUNT]) {
+    const size_t page_size = snapshot->header.page_size;
+    const size_t min_size[STATS_LARGE] = {
+        page_round(layout->tiny_max * CHUNK_PER_ZONE + ZONE_METADATA_SIZE, page_size),
+        page_round(layout->small_max * CHUNK_PER_ZONE + ZONE_METADATA_SIZE, page_size),
+        page_round(page_round(MEDIUM_CHUNK_SIZE + CHUNK_METADATA_SIZE, page_size) * MEDIUM_CHUNK_PER_ZONE
+                   + ZONE_METADATA_SIZE, page_size),
+    };
+    size_t bytes[STATS_LARGE] = {0};
+    const chunk_record_t *chunk;
+    size_t size;
+    size_t total = 0;
+
+    memset(mapped, 0, sizeof(*mapped) * STATS_CLASS_COUNT);
+    for (size_t i = 0; i < snapshot->chunk_count; i++) {
+        chunk = &snapshot->chunks[i];
+        if (chunk->free) {
+            continue;
+        }
+        size = chunk->class == STATS_LARGE ? chunk->size - CHUNK_METADATA_SIZE : chunk->size;
+        if (size <= layout->tiny_max) {
+            bytes[STATS_TINY] += size + CHUNK_METADATA_SIZE;
+        } else if (size <= layout->small_max) {
+            bytes[STATS_SMALL] += size + CHUNK_METADATA_SIZE;
+        } else if (size <= layout->medium_max) {
+            bytes[STATS_MEDIUM] += page_round(size + CHUNK_METADATA_SIZE, page_size);
+        } else {
+            mapped[STATS_LARGE] += page_round(size + CHUNK_METADATA_SIZE, page_size);
+        }
+    }
+    for (size_t i = 0; i < STATS_LARGE; i++) {
+        mapped[i] = layout_zones(bytes[i], min_size[i], page_size);
+    }
+    for (size_t i = 0; i < STATS_CLASS_COUNT; i++) {
+        total += mapped[i];
+    }
+    return total;
+}
+
+/**
+ * @brief Get the bytes a class maps to hold \a bytes of chunks: zones of
+ * \a min_size until it maps ZONE_GROWTH_RATIO times that, then a
+ * 1/ZONE_GROWTH_RATIO of what it maps, up to ZONE_GROWTH_MAX
+ */
+static size_t layout_zones(size_t bytes, size_t min_size, size_t page_size) {
+    size_t mapped = 0;
+    size_t payload = 0;
+    size_t zone_size;
+
+    while (payload < bytes) {
+        zone_size = mapped / ZONE_GROWTH_RATIO;
+        zone_size = zone_size > ZONE_GROWTH_MAX ? ZONE_GROWTH_MAX : zone_size;
+        zone_size = zone_size <= min_size ? min_size : zone_size - zone_size % page_size;
+        mapped += zone_size;
+        payload += zone_size - ZONE_METADATA_SIZE;
+    }
+    return mapped;
+}
+
+static size_t page_round(size_t size, size_t page_size) {
+    return (size + page_size - 1) / page_size * page_size;
+}
+
+static int chunk_compare(const void *a, const void *b) {
+    const chunk_record_t *x = a;
+    const chunk_record_t *y = b;
+
+    if (x->address != y->address) {
+        return x->address < y->address ? -1 : 1;
+    }
+    if (x->size != y->size) {
+        return x->size < y->size ? -1 : 1;
+    }
+    return 0;
+}